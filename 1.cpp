@@ -7,30 +7,264 @@
 #include <semaphore.h> // Библиотека для работы с POSIX семафорами
 #include <condition_variable> // Библиотека для условных переменных
 #include <atomic>   // Библиотека для атомарных операций
+#include <algorithm> // Библиотека для сортировки и поиска
+#include <cmath>    // Библиотека для математических функций
+#include <cstdint>  // Библиотека для целых типов фиксированного размера
+#include <cstdlib>  // Библиотека для разбора чисел
+#include <cstring>  // Библиотека для копирования памяти
+#include <functional> // Библиотека для функциональных объектов
+#include <iomanip>  // Библиотека для форматирования вывода
+#include <memory>   // Библиотека для умных указателей
+#include <numeric>  // Библиотека для суммирования
+#include <sstream>  // Библиотека для строковых потоков
+#include <stdexcept> // Библиотека для стандартных исключений
+#include <string>   // Библиотека для работы со строками
+#include <unistd.h> // Библиотека для получения имени хоста
+#include <cerrno>   // Библиотека для кодов ошибок
+#include <climits>  // Библиотека для предельных значений
+#include <ctime>    // Библиотека для структуры timespec
+#include <system_error> // Библиотека для системных исключений
+#include <linux/futex.h> // Библиотека для констант futex
+#include <sys/syscall.h> // Библиотека для системных вызовов
+#include <sys/ioctl.h> // Библиотека для управления perf-счётчиками
+#include <sys/resource.h> // Библиотека для статистики использования ресурсов
+#include <linux/perf_event.h> // Библиотека для аппаратных счётчиков производительности
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // Библиотека для чтения счётчика тактов
+#endif
+#include <type_traits> // Библиотека для выбора типов на этапе компиляции
+#include <cctype>   // Библиотека для классификации символов
+#include <fstream>  // Библиотека для чтения файлов sysfs
+#include <map>      // Библиотека для ассоциативных массивов
+#include <set>      // Библиотека для множеств
+#include <tuple>    // Библиотека для кортежей
+#include <array>    // Библиотека для массивов фиксированного размера
+#include <dirent.h> // Библиотека для чтения каталогов
+#include <pthread.h> // Библиотека для закрепления потоков за процессорами
+#include <sched.h>  // Библиотека для масок процессоров
 
-#define N 500 // Константа, определяющая количество итераций для потоков
+#define N 500 // Количество итераций для потоков по умолчанию
 
 using namespace std;
 
-// Функция для генерации случайного символа ASCII
-void randomSymbols(char& symbol) { 
-    random_device rd; // Использует аппаратный генератор случайных чисел
-    mt19937 gen(rd()); // Инициализация генератора случайных чисел
-    uniform_int_distribution<> dis(32, 126); // Определение диапазона ASCII символов
-    symbol = static_cast<char>(dis(gen)); // Генерация случайного символа
+// ---------------------------------------------------------------------------
+// Генерация случайных символов
+// ---------------------------------------------------------------------------
+
+const int SYMBOL_MIN = 32; // Первый печатный символ ASCII
+const int SYMBOL_RANGE = 95; // Количество печатных символов ASCII (32..126)
+
+// Вид генератора случайных чисел
+enum class RngKind { Xoshiro, Pcg, Mt };
+
+RngKind symbolRngKind = RngKind::Xoshiro; // Генератор, используемый потоками
+atomic<uint64_t> symbolSeed{0}; // Общее зерно; 0 - взять из random_device
+atomic<uint64_t> symbolStreamCounter{0}; // Номер следующего потока генерации
+
+// Функция SplitMix64 для разворачивания зерна в состояние генераторов
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Функция циклического сдвига влево
+inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Функция отображения 16 случайных бит в печатный символ (умножение со сдвигом, без деления)
+inline char toSymbol(uint64_t bits16) {
+    return static_cast<char>(SYMBOL_MIN + ((bits16 & 0xFFFF) * SYMBOL_RANGE >> 16));
+}
+
+// Функция для получения зерна потока: общее зерно плюс порядковый номер потока
+uint64_t nextStreamSeed() {
+    uint64_t seed = symbolSeed.load(memory_order_relaxed);
+    if (seed == 0) { // Зерно не задано - один раз читаем random_device
+        random_device rd;
+        uint64_t fresh = (static_cast<uint64_t>(rd()) << 32) | rd();
+        fresh |= 1; // Зерно не должно быть нулевым
+        uint64_t expected = 0;
+        symbolSeed.compare_exchange_strong(expected, fresh);
+        seed = symbolSeed.load(memory_order_relaxed);
+    }
+    uint64_t stream = symbolStreamCounter.fetch_add(1, memory_order_relaxed); // Номер потока генерации
+    return seed ^ (stream * 0xD1B54A32D192ED03ULL);
+}
+
+// Генератор xoshiro256** из нескольких независимых дорожек.
+// Состояние хранится по компонентам, чтобы цикл по дорожкам векторизовался
+class XoshiroLanes {
+public:
+    static constexpr int LANES = 4; // Количество дорожек
+
+    XoshiroLanes(uint64_t seed) {
+        for (int l = 0; l < LANES; l++) {
+            s0[l] = splitMix64(seed);
+            s1[l] = splitMix64(seed);
+            s2[l] = splitMix64(seed);
+            s3[l] = splitMix64(seed);
+        }
+    }
+
+    // Метод для получения очередного числа из каждой дорожки
+    void next(uint64_t out[LANES]) {
+        for (int l = 0; l < LANES; l++) {
+            out[l] = rotl64(s1[l] * 5, 7) * 9;
+            uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = rotl64(s3[l], 45);
+        }
+    }
+
+private:
+    alignas(32) uint64_t s0[LANES], s1[LANES], s2[LANES], s3[LANES]; // Состояние дорожек
+};
+
+// Генератор PCG32 (XSH-RR) из нескольких независимых дорожек
+class PcgLanes {
+public:
+    static constexpr int LANES = 4; // Количество дорожек
+
+    PcgLanes(uint64_t seed) {
+        for (int l = 0; l < LANES; l++) {
+            inc[l] = (splitMix64(seed) << 1) | 1; // Приращение должно быть нечётным
+            state[l] = splitMix64(seed) + inc[l];
+        }
+    }
+
+    // Метод для получения очередных 64 бит из каждой дорожки (два шага PCG32)
+    void next(uint64_t out[LANES]) {
+        for (int l = 0; l < LANES; l++) {
+            uint64_t hi = step(l);
+            out[l] = (hi << 32) | step(l);
+        }
+    }
+
+private:
+    // Метод одного шага PCG32
+    uint32_t step(int l) {
+        uint64_t old = state[l];
+        state[l] = old * 6364136223846793005ULL + inc[l];
+        uint32_t xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rot = static_cast<uint32_t>(old >> 59);
+        return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+    }
+
+    uint64_t state[LANES], inc[LANES]; // Состояние и приращение дорожек
+};
+
+// Генератор символов на основе выбранного движка; один экземпляр на поток
+template <typename Engine>
+class LaneSymbolGenerator {
+public:
+    LaneSymbolGenerator() : engine(nextStreamSeed()) {}
+
+    // Метод для заполнения буфера печатными символами
+    void fill(char* buffer, size_t count) {
+        const size_t block = Engine::LANES * 4; // Символов за один шаг всех дорожек
+        uint64_t words[Engine::LANES]; // Случайные числа дорожек
+        size_t i = 0;
+        for (; i + block <= count; i += block) {
+            engine.next(words);
+            for (int l = 0; l < Engine::LANES; l++) { // Каждое 64-битное число даёт 4 символа
+                buffer[i + l * 4 + 0] = toSymbol(words[l]);
+                buffer[i + l * 4 + 1] = toSymbol(words[l] >> 16);
+                buffer[i + l * 4 + 2] = toSymbol(words[l] >> 32);
+                buffer[i + l * 4 + 3] = toSymbol(words[l] >> 48);
+            }
+        }
+        if (i < count) { // Хвост короче блока
+            engine.next(words);
+            for (size_t j = 0; i < count; i++, j++) {
+                buffer[i] = toSymbol(words[j / 4] >> (16 * (j % 4)));
+            }
+        }
+    }
+
+private:
+    Engine engine; // Движок генерации
+};
+
+// Эталонный генератор на mt19937, но инициализируемый один раз на поток
+class MtSymbolGenerator {
+public:
+    MtSymbolGenerator() : gen(static_cast<mt19937::result_type>(nextStreamSeed())), dis(SYMBOL_MIN, SYMBOL_MIN + SYMBOL_RANGE - 1) {}
+
+    // Метод для заполнения буфера печатными символами
+    void fill(char* buffer, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            buffer[i] = static_cast<char>(dis(gen));
+        }
+    }
+
+private:
+    mt19937 gen; // Генератор случайных чисел
+    uniform_int_distribution<> dis; // Диапазон ASCII символов
+};
+
+// Функция для заполнения буфера случайными печатными символами генератором текущего потока
+void fillRandomSymbols(char* buffer, size_t count) {
+    switch (symbolRngKind) {
+    case RngKind::Xoshiro: {
+        thread_local LaneSymbolGenerator<XoshiroLanes> xoshiro; // Состояние потока
+        xoshiro.fill(buffer, count);
+        break;
+    }
+    case RngKind::Pcg: {
+        thread_local LaneSymbolGenerator<PcgLanes> pcg; // Состояние потока
+        pcg.fill(buffer, count);
+        break;
+    }
+    case RngKind::Mt: {
+        thread_local MtSymbolGenerator mt; // Состояние потока
+        mt.fill(buffer, count);
+        break;
+    }
+    }
+}
+
+thread_local uint64_t futexWaitCount = 0; // Количество засыпаний на futex в текущем потоке
+
+// Функция для ожидания на futex, пока значение по адресу равно expected.
+// timeout - относительный тайм-аут или nullptr для ожидания без ограничения
+inline long futexWait(void* address, uint32_t expected, const timespec* timeout = nullptr) {
+    futexWaitCount++; // Медленный путь, поэтому учёт ничего не стоит
+    return syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+// Функция для пробуждения не более count потоков, ждущих на futex
+inline long futexWake(void* address, int count) {
+    return syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
 }
 
 // Класс для реализации семафора
 class Semaphore { 
 public:
     // Конструктор, инициализирующий семафор с начальным значением
-    Semaphore(int initialCount) : iCount(initialCount) {
-        sem_init(&sem, 0, initialCount); // Инициализация POSIX семафора
+    Semaphore(int initialCount) {
+        if (sem_init(&sem, 0, initialCount) != 0) { // Инициализация POSIX семафора
+            throw system_error(errno, generic_category(), "sem_init");
+        }
     }
+
+    // Деструктор, освобождающий POSIX семафор
+    ~Semaphore() {
+        sem_destroy(&sem);
+    }
+
+    Semaphore(const Semaphore&) = delete; // sem_t нельзя копировать
+    Semaphore& operator=(const Semaphore&) = delete;
     
     // Метод для захвата ресурса
     void acquire() { 
-        sem_wait(&sem); // Уменьшает счётчик семафора
+        while (sem_wait(&sem) != 0 && errno == EINTR) {} // Уменьшает счётчик семафора, повтор при прерывании сигналом
     }
 
     // Метод для освобождения ресурса
@@ -40,7 +274,6 @@ public:
 
 private:
     sem_t sem;  // Объект семафора
-    int iCount; // Начальное значение семафора
 };
 
 // Класс для реализации упрощенного семафора
@@ -73,6 +306,109 @@ private:
     int iCount, mCount; // Начальное и максимальное значение счётчиков семафора
 };
 
+// Класс для реализации семафора на futex.
+// Счётчик и число ждущих потоков хранятся в одном 64-битном слове, поэтому
+// захват и освобождение без конкуренции - одна атомарная операция, а
+// системный вызов futex выполняется, только когда потоку действительно нужно ждать
+class FutexSemaphore {
+public:
+    // Конструктор
+    FutexSemaphore(int initialCount, int maxCount) : state(static_cast<uint32_t>(initialCount)), mCount(static_cast<uint32_t>(maxCount)) {}
+
+    // Метод для захвата семафора
+    void acquire() {
+        if (!try_acquire()) {
+            acquireSlow(nullptr); // Ожидание без тайм-аута
+        }
+    }
+
+    // Метод для попытки захвата без ожидания
+    bool try_acquire() {
+        uint64_t s = state.load(memory_order_relaxed);
+        while (count(s) > 0) {
+            if (state.compare_exchange_weak(s, s - 1, memory_order_acquire, memory_order_relaxed)) {
+                return true; // Счётчик уменьшен
+            }
+        }
+        return false;
+    }
+
+    // Метод для захвата с ограничением времени ожидания
+    template <typename Rep, typename Period>
+    bool try_acquire_for(const chrono::duration<Rep, Period>& timeout) {
+        return try_acquire_until(chrono::steady_clock::now() + timeout);
+    }
+
+    // Метод для захвата с ожиданием до заданного момента
+    template <typename Clock, typename Duration>
+    bool try_acquire_until(const chrono::time_point<Clock, Duration>& deadline) {
+        if (try_acquire()) {
+            return true;
+        }
+        auto steadyDeadline = chrono::steady_clock::now() + (deadline - Clock::now()); // Перевод в монотонные часы
+        return acquireSlow(&steadyDeadline);
+    }
+
+    // Метод для освобождения семафора; возвращает false, если счётчик уже максимальный
+    bool release() {
+        uint64_t s = state.load(memory_order_relaxed);
+        do {
+            if (count(s) >= mCount) {
+                return false; // Превышение максимального значения не допускается
+            }
+        } while (!state.compare_exchange_weak(s, s + 1, memory_order_release, memory_order_relaxed));
+        if (waiters(s) > 0) { // Будим поток, только если кто-то ждёт
+            futexWake(countAddress(), 1);
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint64_t WAITER = 1ULL << 32; // Единица в счётчике ждущих потоков
+
+    static uint32_t count(uint64_t s) { return static_cast<uint32_t>(s); }
+    static uint32_t waiters(uint64_t s) { return static_cast<uint32_t>(s >> 32); }
+
+    // Метод для получения адреса младшей половины слова (счётчика), на которой ждёт futex
+    uint32_t* countAddress() {
+        uint32_t* words = reinterpret_cast<uint32_t*>(&state);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return words + 1;
+#else
+        return words;
+#endif
+    }
+
+    // Метод медленного пути: регистрация ждущего потока и сон на futex
+    bool acquireSlow(const chrono::steady_clock::time_point* deadline) {
+        uint64_t s = state.fetch_add(WAITER, memory_order_relaxed) + WAITER; // Регистрация ждущего
+        while (true) {
+            while (count(s) > 0) { // Захват и снятие регистрации одной операцией
+                if (state.compare_exchange_weak(s, s - 1 - WAITER, memory_order_acquire, memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            timespec ts; // Оставшееся время ожидания
+            timespec* tsPtr = nullptr;
+            if (deadline) {
+                auto left = chrono::duration_cast<chrono::nanoseconds>(*deadline - chrono::steady_clock::now()).count();
+                if (left <= 0) {
+                    state.fetch_sub(WAITER, memory_order_relaxed); // Тайм-аут: снятие регистрации
+                    return false;
+                }
+                ts.tv_sec = left / 1000000000;
+                ts.tv_nsec = left % 1000000000;
+                tsPtr = &ts;
+            }
+            futexWait(countAddress(), 0, tsPtr); // Сон, пока счётчик равен нулю
+            s = state.load(memory_order_relaxed);
+        }
+    }
+
+    atomic<uint64_t> state; // Младшие 32 бита - счётчик, старшие - число ждущих потоков
+    uint32_t mCount; // Максимальное значение счётчика
+};
+
 // Класс для реализации барьера
 class Barrier { 
 public:
@@ -96,12 +432,240 @@ public:
         }
     }
 
+    // Метод для совместимости с барьерами, которым нужен номер потока
+    void wait(int) {
+        wait();
+    }
+
 private:
     mutex mtx; // Мьютекс для защиты доступа
     condition_variable cv; // Условная переменная
     int initialCount, maxCount, generationCount; // Счётчики для управления барьером
 };
 
+const size_t CACHE_LINE = 64; // Размер строки кэша
+const int SPIN_LIMIT = 1024; // Количество активных проверок перед засыпанием
+
+// Функция для выбора числа активных проверок: при переподписке ядер
+// активное ожидание только отнимает время у потока, которого ждут
+inline int spinLimitFor(int threadCount) {
+    unsigned cores = thread::hardware_concurrency();
+    return cores != 0 && static_cast<unsigned>(threadCount) > cores ? 0 : SPIN_LIMIT;
+}
+
+// Функция для паузы внутри цикла активного ожидания
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause(); // Инструкция pause снижает нагрузку на конвейер и шину
+#elif defined(__aarch64__)
+    asm volatile("yield"); // Аналог pause для ARM
+#endif
+}
+
+// Атомарный счётчик, занимающий целую строку кэша
+struct alignas(CACHE_LINE) PaddedAtomic {
+    atomic<uint32_t> value{0};
+};
+
+// Реестр номеров участников для барьеров, которым нужен номер потока.
+// Номер выдаётся потоку при первом вызове и запоминается в памяти потока
+class ParticipantRegistry {
+public:
+    ParticipantRegistry() : serial(nextSerial.fetch_add(1, memory_order_relaxed)), next(0) {}
+
+    // Метод для получения номера текущего потока
+    int id() {
+        thread_local vector<pair<uint64_t, int>> ids; // Номера потока во всех реестрах
+        for (const auto& entry : ids) {
+            if (entry.first == serial) {
+                return entry.second;
+            }
+        }
+        int assigned = next.fetch_add(1, memory_order_relaxed); // Новый участник
+        ids.emplace_back(serial, assigned);
+        return assigned;
+    }
+
+private:
+    static atomic<uint64_t> nextSerial; // Уникальный номер следующего реестра
+    uint64_t serial; // Уникальный номер реестра (адрес может повториться, номер - нет)
+    atomic<int> next; // Следующий свободный номер участника
+};
+
+atomic<uint64_t> ParticipantRegistry::nextSerial{1};
+
+// Класс централизованного барьера с обращением смысла (sense-reversing).
+// Потоки ждут смены флага сначала активно, затем на futex
+class SenseBarrier {
+public:
+    // Конструктор
+    SenseBarrier(int count) : threadCount(count), spinLimit(spinLimitFor(count)) {
+        remaining.value = static_cast<uint32_t>(count);
+    }
+
+    // Метод для ожидания достижения барьера всеми потоками
+    void wait() {
+        uint32_t localSense = sense.value.load(memory_order_acquire); // Флаг не сменится, пока этот поток не пришёл
+        if (remaining.value.fetch_sub(1, memory_order_acq_rel) == 1) { // Последний поток
+            remaining.value.store(static_cast<uint32_t>(threadCount), memory_order_relaxed); // Сброс счётчика
+            sense.value.store(localSense ^ 1, memory_order_seq_cst); // Смена флага освобождает остальных
+            if (sleepers.value.load(memory_order_seq_cst) > 0) {
+                futexWake(&sense.value, INT_MAX); // Будим спящих, только если они есть
+            }
+            return;
+        }
+        for (int spin = 0; spin < spinLimit; spin++) { // Активное ожидание
+            if (sense.value.load(memory_order_acquire) != localSense) {
+                return;
+            }
+            cpuRelax();
+        }
+        sleepers.value.fetch_add(1, memory_order_seq_cst); // Регистрация спящего потока
+        while (sense.value.load(memory_order_acquire) == localSense) {
+            futexWait(&sense.value, localSense); // Сон, пока флаг не сменится
+        }
+        sleepers.value.fetch_sub(1, memory_order_relaxed);
+    }
+
+    // Метод для совместимости с барьерами, которым нужен номер потока
+    void wait(int) {
+        wait();
+    }
+
+private:
+    int threadCount; // Количество потоков
+    int spinLimit; // Количество активных проверок перед засыпанием
+    PaddedAtomic remaining; // Количество ещё не пришедших потоков
+    PaddedAtomic sense; // Глобальный флаг фазы
+    PaddedAtomic sleepers; // Количество потоков, спящих на futex
+};
+
+// Класс барьера с объединяющим деревом: потоки приходят в узлы по FAN_IN штук,
+// последний пришедший в узел поднимается к родителю, поэтому ни один
+// счётчик не разделяется более чем FAN_IN потоками
+class TreeBarrier {
+public:
+    static constexpr int FAN_IN = 4; // Степень ветвления дерева
+
+    // Конструктор
+    TreeBarrier(int count) : spinLimit(spinLimitFor(count)) {
+        int width = (count + FAN_IN - 1) / FAN_IN; // Количество листьев
+        int levelStart = 0; // Индекс первого узла текущего уровня
+        int children = count; // Количество входов на текущем уровне
+        while (true) {
+            for (int i = 0; i < width; i++) {
+                int fanIn = min(FAN_IN, children - i * FAN_IN); // Входов в узел
+                nodes.push_back({fanIn, -1});
+            }
+            if (width == 1) {
+                break;
+            }
+            int nextStart = levelStart + width; // Следующий уровень
+            for (int i = 0; i < width; i++) {
+                nodes[levelStart + i].parent = nextStart + i / FAN_IN;
+            }
+            levelStart = nextStart;
+            children = width;
+            width = (width + FAN_IN - 1) / FAN_IN;
+        }
+        counters = vector<PaddedAtomic>(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++) {
+            counters[i].value = static_cast<uint32_t>(nodes[i].fanIn);
+        }
+    }
+
+    // Метод для ожидания достижения барьера всеми потоками
+    void wait() {
+        wait(registry.id());
+    }
+
+    // Метод для ожидания с явным номером потока
+    void wait(int threadIndex) {
+        uint32_t localSense = sense.value.load(memory_order_acquire); // Текущая фаза
+        int node = threadIndex / FAN_IN; // Лист, в который приходит поток
+        while (node >= 0) {
+            if (counters[node].value.fetch_sub(1, memory_order_acq_rel) != 1) {
+                break; // Не последний в узле - дальше поднимается другой поток
+            }
+            counters[node].value.store(static_cast<uint32_t>(nodes[node].fanIn), memory_order_relaxed); // Сброс узла
+            if (nodes[node].parent < 0) { // Корень: все потоки пришли
+                sense.value.store(localSense ^ 1, memory_order_release);
+                return;
+            }
+            node = nodes[node].parent;
+        }
+        for (int spin = 0; sense.value.load(memory_order_acquire) == localSense; spin++) {
+            if (spin < spinLimit) {
+                cpuRelax(); // Активное ожидание
+            }
+            else {
+                this_thread::yield(); // Передача управления при переподписке
+            }
+        }
+    }
+
+private:
+    // Узел дерева
+    struct Node {
+        int fanIn; // Количество входов узла
+        int parent; // Индекс родителя (-1 у корня)
+    };
+
+    vector<Node> nodes; // Узлы дерева, листья идут первыми
+    vector<PaddedAtomic> counters; // Счётчики узлов, каждый в своей строке кэша
+    int spinLimit; // Количество активных проверок перед уступкой процессора
+    PaddedAtomic sense; // Флаг фазы
+    ParticipantRegistry registry; // Номера потоков
+};
+
+// Класс барьера рассеивания (dissemination): за ceil(log2 N) раундов поток i
+// сигналит потоку (i + 2^r) mod N и ждёт сигнала от (i - 2^r) mod N.
+// Каждый поток ждёт только на собственных флагах
+class DisseminationBarrier {
+public:
+    // Конструктор
+    DisseminationBarrier(int count) : threadCount(count), rounds(0), spinLimit(spinLimitFor(count)) {
+        while ((1 << rounds) < count) {
+            rounds++;
+        }
+        flags = vector<PaddedAtomic>(static_cast<size_t>(count) * max(rounds, 1));
+        episodes = vector<PaddedAtomic>(count);
+    }
+
+    // Метод для ожидания достижения барьера всеми потоками
+    void wait() {
+        wait(registry.id());
+    }
+
+    // Метод для ожидания с явным номером потока
+    void wait(int threadIndex) {
+        // Флаги - монотонные счётчики эпизодов, поэтому их не нужно сбрасывать
+        uint32_t episode = episodes[threadIndex].value.load(memory_order_relaxed) + 1;
+        episodes[threadIndex].value.store(episode, memory_order_relaxed);
+        for (int r = 0; r < rounds; r++) {
+            int partner = (threadIndex + (1 << r)) % threadCount; // Кому сигналим в раунде r
+            flags[static_cast<size_t>(partner) * rounds + r].value.fetch_add(1, memory_order_release);
+            auto& mine = flags[static_cast<size_t>(threadIndex) * rounds + r].value; // Свой флаг раунда
+            for (int spin = 0; static_cast<int32_t>(mine.load(memory_order_acquire) - episode) < 0; spin++) {
+                if (spin < spinLimit) {
+                    cpuRelax(); // Активное ожидание
+                }
+                else {
+                    this_thread::yield(); // Передача управления при переподписке
+                }
+            }
+        }
+    }
+
+private:
+    int threadCount; // Количество потоков
+    int rounds; // Количество раундов
+    int spinLimit; // Количество активных проверок перед уступкой процессора
+    vector<PaddedAtomic> flags; // Флаги [поток][раунд], каждый в своей строке кэша
+    vector<PaddedAtomic> episodes; // Номер текущего эпизода каждого потока
+    ParticipantRegistry registry; // Номера потоков
+};
+
 // Класс для реализации монитора
 class Monitor { 
 public:
@@ -130,183 +694,2259 @@ private:
     bool isReady; // Состояние захваченности монитора
 };
 
-// Функция для работы с мьютексом
-void threadMutex(char& symbol, mutex& mtx, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) { 
-        randomSymbols(symbol); // Генерация символа
-        lock_guard<mutex> lock(mtx); // Захват мьютекса
-        allSymbols.push_back(symbol); // Добавление символа в вектор
+// Функция для одного шага активного ожидания: сначала pause, а после
+// SPIN_LIMIT шагов - уступка процессора, чтобы владелец блокировки,
+// вытесненный планировщиком, смог её отпустить
+inline void spinOnce(int& spins) {
+    if (spins < SPIN_LIMIT) {
+        spins++;
+        cpuRelax();
     }
-}
-
-// Функция для работы с семафором
-void threadSemaphore(char& symbol, Semaphore& sem, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) {
-        randomSymbols(symbol); // Генерация символа
-        sem.acquire(); // Захват семафора
-        allSymbols.push_back(symbol); // Добавление символа в вектор
-        sem.release(); // Освобождение семафора
+    else {
+        this_thread::yield();
     }
 }
 
-// Функция для работы с упрощенным семафором
-void threadSemaphoreSlim(char& symbol, SemaphoreSlim& semSlim, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) {
-        randomSymbols(symbol); // Генерация символа
-        semSlim.acquire(); // Захват семафора
-        allSymbols.push_back(symbol); // Добавление символа в вектор
-        semSlim.release(); // Освобождение семафора
-    }
-}
+const int MAX_NESTED_LOCKS = 8; // Максимальная вложенность очередных блокировок в одном потоке
+
+// Класс спинлока TTAS (test-and-test-and-set) с экспоненциальной задержкой.
+// Ожидающие потоки читают флаг из своего кэша и пишут в него только тогда,
+// когда он выглядит свободным
+class TTASLock {
+public:
+    static constexpr int MIN_BACKOFF = 4; // Начальная задержка в инструкциях pause
+    static constexpr int MAX_BACKOFF = 1024; // Максимальная задержка
 
-// Функция для работы с барьером
-void threadBarrier(char& symbol, Barrier& barrier, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) {
-        randomSymbols(symbol); // Генерация символа
-        barrier.wait(); // Ожидание достижения барьера
-        allSymbols.push_back(symbol); // Добавление символа в вектор
+    // Метод для захвата блокировки
+    void lock() {
+        int backoff = MIN_BACKOFF; // Текущая задержка
+        int spins = 0; // Шаги активного ожидания
+        while (true) {
+            while (locked.load(memory_order_relaxed)) { // Чтение без записи в строку кэша
+                spinOnce(spins);
+            }
+            if (!locked.exchange(true, memory_order_acquire)) {
+                return; // Блокировка захвачена
+            }
+            for (int i = 0; i < backoff; i++) { // Проиграли гонку - ждём дольше
+                cpuRelax();
+            }
+            backoff = min(backoff * 2, MAX_BACKOFF);
+        }
     }
-}
 
-// Функция для работы с монитором
-void threadMonitor(char& symbol, Monitor& monitor, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) {
-        randomSymbols(symbol); // Генерация символа
-        monitor.locker(); // Захват монитора
-        allSymbols.push_back(symbol); // Добавление символа в вектор
-        monitor.unlocker(); // Освобождение монитора
+    // Метод для попытки захвата без ожидания
+    bool try_lock() {
+        return !locked.load(memory_order_relaxed) && !locked.exchange(true, memory_order_acquire);
     }
-}
 
-// Функция для работы со спинлоком
-void threadSpinLock(char& symbol, atomic_flag& spinLock, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) {
-        randomSymbols(symbol); // Генерация символа
-        while (spinLock.test_and_set(memory_order_acquire)) {} // Ожидание, пока флаг не будет сброшен
-        allSymbols.push_back(symbol); // Добавление символа в вектор
-        spinLock.clear(memory_order_release); // Сброс флага
+    // Метод для освобождения блокировки
+    void unlock() {
+        locked.store(false, memory_order_release);
     }
-}
 
-// Функция для работы с спин-ожиданием
-void threadSpinWait(char& symbol, atomic_flag& spinLock, vector<char>& allSymbols) { 
-    for (int i = 0; i < N; i++) {
-        randomSymbols(symbol); // Генерация символа
-        while (spinLock.test_and_set(memory_order_acquire)) { // Ожидание, пока флаг не будет сброшен
-            this_thread::yield(); // Передача управления другим потокам
+private:
+    alignas(CACHE_LINE) atomic<bool> locked{false}; // Флаг захвата в отдельной строке кэша
+};
+
+// Класс билетного спинлока: потоки получают блокировку строго в порядке прихода
+class TicketLock {
+public:
+    // Метод для захвата блокировки
+    void lock() {
+        uint32_t ticket = nextTicket.fetch_add(1, memory_order_relaxed); // Номер в очереди
+        int spins = 0; // Шаги активного ожидания
+        while (true) {
+            uint32_t serving = nowServing.load(memory_order_acquire);
+            if (serving == ticket) {
+                return; // Наша очередь
+            }
+            uint32_t ahead = ticket - serving; // Задержка пропорциональна числу потоков впереди
+            for (uint32_t i = 1; i < ahead; i++) {
+                cpuRelax();
+            }
+            spinOnce(spins);
         }
-        allSymbols.push_back(symbol); // Добавление символа в вектор
-        spinLock.clear(memory_order_release); // Сброс флага
     }
-}
 
-// Основная функция
-int main() {
-    vector<char> allSymbols; // Вектор для хранения сгенерированных символов
-    mutex mtx; // Мьютекс для защиты доступа к вектору
-    char symbol; // Переменная для хранения символа
-    
-    // Тестирование мьютекса
-    auto start = chrono::high_resolution_clock::now(); // Запуск таймера
-    vector<thread> threads; // Вектор потоков
-    for (int i = 0; i < 4; i++) { // Запуск 4 потоков
-        threads.emplace_back(threadMutex, ref(symbol), ref(mtx), ref(allSymbols)); // Создание потоков
-    }
-    for (auto& t : threads) {
-        t.join(); // Ожидание завершения потоков
+    // Метод для освобождения блокировки (пишет только владелец)
+    void unlock() {
+        nowServing.store(nowServing.load(memory_order_relaxed) + 1, memory_order_release);
     }
-    auto end = chrono::high_resolution_clock::now(); // Завершение таймера
-    chrono::duration<double> elapsed = end - start; // Вычисление времени выполнения
-    cout << "Mutex time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
-    threads.clear(); // Очистка вектора потоков
-    allSymbols.clear(); // Очистка вектора символов
 
-    // Тестирование семафора
-    Semaphore sem(4); // Инициализация семафора с максимальным значением 4
-    start = chrono::high_resolution_clock::now(); // Запуск таймера
-    for (int i = 0; i < 4; i++) {
-        threads.emplace_back(threadSemaphore, ref(symbol), ref(sem), ref(allSymbols)); // Создание потоков
-    }
-    for (auto& t : threads) {
-        t.join(); // Ожидание завершения потоков
-    }
-    end = chrono::high_resolution_clock::now(); // Завершение таймера
-    elapsed = end - start; // Вычисление времени выполнения
-    cout << "Semaphore time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
-    threads.clear(); // Очистка вектора потоков
-    allSymbols.clear(); // Очистка вектора символов
+private:
+    alignas(CACHE_LINE) atomic<uint32_t> nextTicket{0}; // Следующий выдаваемый билет
+    alignas(CACHE_LINE) atomic<uint32_t> nowServing{0}; // Обслуживаемый билет
+};
 
-    // Тестирование упрощенного семафора
-    SemaphoreSlim semSlim(4, 4); // Инициализация упрощенного семафора
-    start = chrono::high_resolution_clock::now(); // Запуск таймера
-    for (int i = 0; i < 4; i++) {
-        threads.emplace_back(threadSemaphoreSlim, ref(symbol), ref(semSlim), ref(allSymbols)); // Создание потоков
+// Узел очереди блокировки MCS, занимает целую строку кэша
+struct alignas(CACHE_LINE) McsNode {
+    atomic<McsNode*> next{nullptr}; // Следующий поток в очереди
+    atomic<bool> locked{false}; // Поток ждёт, пока флаг установлен
+};
+
+// Класс спинлока MCS: каждый поток ждёт на флаге собственного узла,
+// а освобождение передаёт блокировку следующему в очереди
+class MCSLock {
+public:
+    // Метод для захвата блокировки
+    void lock() {
+        if (localNodes.depth == MAX_NESTED_LOCKS) {
+            throw length_error("MCSLock: nesting exceeds MAX_NESTED_LOCKS");
+        }
+        McsNode* node = &localNodes.nodes[localNodes.depth++]; // Узел текущего потока
+        node->next.store(nullptr, memory_order_relaxed);
+        node->locked.store(true, memory_order_relaxed);
+        McsNode* pred = tail.exchange(node, memory_order_acq_rel); // Встаём в конец очереди
+        if (pred != nullptr) {
+            pred->next.store(node, memory_order_release); // Сообщаем предшественнику о себе
+            int spins = 0; // Шаги активного ожидания
+            while (node->locked.load(memory_order_acquire)) {
+                spinOnce(spins);
+            }
+        }
+        owner = node; // Узел владельца нужен для освобождения
     }
-    for (auto& t : threads) {
-        t.join(); // Ожидание завершения потоков
+
+    // Метод для освобождения блокировки
+    void unlock() {
+        McsNode* node = owner;
+        McsNode* succ = node->next.load(memory_order_acquire);
+        if (succ == nullptr) {
+            McsNode* expected = node;
+            if (tail.compare_exchange_strong(expected, nullptr, memory_order_release, memory_order_relaxed)) {
+                localNodes.depth--; // Очередь пуста
+                return;
+            }
+            int spins = 0; // Преемник уже встал в очередь, но ещё не связал узлы
+            while ((succ = node->next.load(memory_order_acquire)) == nullptr) {
+                spinOnce(spins);
+            }
+        }
+        succ->locked.store(false, memory_order_release); // Передача блокировки
+        localNodes.depth--;
     }
-    end = chrono::high_resolution_clock::now(); // Завершение таймера
-    elapsed = end - start; // Вычисление времени выполнения
-    cout << "SemaphoreSlim time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
-    threads.clear(); // Очистка вектора потоков
-    allSymbols.clear(); // Очистка вектора символов
 
-    // Тестирование барьера
-    Barrier barrier(4); // Инициализация барьера для 4 потоков
-    start = chrono::high_resolution_clock::now(); // Запуск таймера
-    for (int i = 0; i < 4; i++) {
-        threads.emplace_back(threadBarrier, ref(symbol), ref(barrier), ref(allSymbols)); // Создание потоков
+    // Метод для создания узлов потока заранее, до начала замера
+    static void prepareThread() {
+        localNodes.nodes[0].locked.store(false, memory_order_relaxed);
     }
-    for (auto& t : threads) {
-        t.join(); // Ожидание завершения потоков
+
+private:
+    // Узлы потока; блокировки, взятые одним потоком, освобождаются в обратном порядке
+    struct NodeStack {
+        McsNode nodes[MAX_NESTED_LOCKS];
+        int depth = 0;
+    };
+    static thread_local NodeStack localNodes;
+
+    alignas(CACHE_LINE) atomic<McsNode*> tail{nullptr}; // Последний узел очереди
+    McsNode* owner = nullptr; // Узел владельца (меняет только владелец)
+};
+
+thread_local MCSLock::NodeStack MCSLock::localNodes;
+
+// Узел очереди блокировки CLH, занимает целую строку кэша
+struct alignas(CACHE_LINE) ClhNode {
+    atomic<bool> locked{false}; // Владелец узла держит или ждёт блокировку
+};
+
+// Класс спинлока CLH: поток ждёт на узле предшественника, а после
+// освобождения забирает этот узел себе для следующего захвата
+class CLHLock {
+public:
+    CLHLock() : tail(new ClhNode) {} // Пустая очередь начинается со свободного узла
+
+    ~CLHLock() {
+        delete tail.load(); // Узел в хвосте свободной блокировки принадлежит ей
     }
-    end = chrono::high_resolution_clock::now(); // Завершение таймера
-    elapsed = end - start; // Вычисление времени выполнения
-    cout << "Barrier time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
-    threads.clear(); // Очистка вектора потоков
-    allSymbols.clear(); // Очистка вектора символов
 
-    // Тестирование спинлока
-    atomic_flag spinLock = ATOMIC_FLAG_INIT; // Инициализация спинлока
-    start = chrono::high_resolution_clock::now(); // Запуск таймера
-    for (int i = 0; i < 4; i++) {
-        threads.emplace_back(threadSpinLock, ref(symbol), ref(spinLock), ref(allSymbols)); // Создание потоков
+    CLHLock(const CLHLock&) = delete;
+    CLHLock& operator=(const CLHLock&) = delete;
+
+    // Метод для захвата блокировки
+    void lock() {
+        if (localNodes.depth == MAX_NESTED_LOCKS) {
+            throw length_error("CLHLock: nesting exceeds MAX_NESTED_LOCKS");
+        }
+        ClhNode* node = localNodes.nodes[localNodes.depth++]; // Узел текущего потока
+        node->locked.store(true, memory_order_relaxed);
+        ClhNode* pred = tail.exchange(node, memory_order_acq_rel); // Встаём в конец очереди
+        int spins = 0; // Шаги активного ожидания
+        while (pred->locked.load(memory_order_acquire)) {
+            spinOnce(spins);
+        }
+        owner = node; // Узлы владельца нужны для освобождения
+        ownerPred = pred;
     }
-    for (auto& t : threads) {
-        t.join(); // Ожидание завершения потоков
+
+    // Метод для освобождения блокировки
+    void unlock() {
+        ClhNode* node = owner;
+        ClhNode* pred = ownerPred;
+        node->locked.store(false, memory_order_release); // Преемник ждёт на нашем узле
+        localNodes.nodes[--localNodes.depth] = pred; // Узел предшественника больше никому не нужен
     }
-    end = chrono::high_resolution_clock::now(); // Завершение таймера
-    elapsed = end - start; // Вычисление времени выполнения
-    cout << "SpinLock time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
-    threads.clear(); // Очистка вектора потоков
-    allSymbols.clear(); // Очистка вектора символов
 
-    // Тестирование спин-ожидания
-    start = chrono::high_resolution_clock::now(); // Запуск таймера
-    for (int i = 0; i < 4; i++) {
-        threads.emplace_back(threadSpinWait, ref(symbol), ref(spinLock), ref(allSymbols)); // Создание потоков
+    // Метод для создания узлов потока заранее: иначе первый lock() выделяет их внутри замера
+    static void prepareThread() {
+        localNodes.nodes[0]->locked.store(false, memory_order_relaxed);
     }
-    for (auto& t : threads) {
-        t.join(); // Ожидание завершения потоков
+
+private:
+    // Узлы потока; блокировки, взятые одним потоком, освобождаются в обратном порядке
+    struct NodeStack {
+        ClhNode* nodes[MAX_NESTED_LOCKS];
+        int depth = 0;
+        NodeStack() {
+            for (auto& node : nodes) {
+                node = new ClhNode;
+            }
+        }
+        ~NodeStack() {
+            for (auto node : nodes) {
+                delete node;
+            }
+        }
+    };
+    static thread_local NodeStack localNodes;
+
+    alignas(CACHE_LINE) atomic<ClhNode*> tail; // Последний узел очереди
+    ClhNode* owner = nullptr; // Узел владельца
+    ClhNode* ownerPred = nullptr; // Узел предшественника владельца
+};
+
+thread_local CLHLock::NodeStack CLHLock::localNodes;
+
+// Функция для чтения дешёвого счётчика времени (такты TSC на x86, иначе наносекунды)
+inline uint64_t readTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Функция для оценки стоимости одной инструкции pause в единицах readTicks (один раз на процесс)
+inline uint64_t pauseCostTicks() {
+    static const uint64_t cost = []() {
+        const int samples = 1000;
+        uint64_t start = readTicks();
+        for (int i = 0; i < samples; i++) {
+            cpuRelax();
+        }
+        return max<uint64_t>(1, (readTicks() - start) / samples);
+    }();
+    return cost;
+}
+
+// Класс адаптивного монитора: короткое активное ожидание с pause перед засыпанием
+// на futex, бюджет ожидания подстраивается по среднему времени удержания.
+// Режим Throughput позволяет новым потокам перехватывать монитор (максимум
+// пропускной способности), режим Fifo передаёт владение напрямую самому
+// давнему спящему потоку, ограничивая хвост задержки
+class AdaptiveMonitor {
+public:
+    enum class Mode { Throughput, Fifo };
+
+    static constexpr uint32_t MIN_SPIN = 16; // Минимальный бюджет активного ожидания, итераций
+    static constexpr uint32_t MAX_SPIN = 4096; // Максимальный бюджет
+
+    // Конструктор
+    AdaptiveMonitor(Mode mode = Mode::Throughput) : mode(mode) {}
+
+    // Метод для захвата монитора
+    void locker() {
+        uint32_t expected = FREE;
+        if (!state.compare_exchange_strong(expected, LOCKED, memory_order_acquire, memory_order_relaxed)) {
+            lockSlow(); // Монитор занят
+        }
+        acquiredAt = readTicks(); // Начало удержания (пишет только владелец)
     }
-    end = chrono::high_resolution_clock::now(); // Завершение таймера
-    elapsed = end - start; // Вычисление времени выполнения
-    cout << "SpinWait time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
-    threads.clear(); // Очистка вектора потоков
-    allSymbols.clear(); // Очистка вектора символов
 
-    // Тестирование монитора
-    Monitor monitor; // Инициализация монитора
-    start = chrono::high_resolution_clock::now(); // Запуск таймера
-    for (int i = 0; i < 4; i++) {
-        threads.emplace_back(threadMonitor, ref(symbol), ref(monitor), ref(allSymbols)); // Создание потоков
+    // Метод для освобождения монитора
+    void unlocker() {
+        updateHoldEstimate(readTicks() - acquiredAt);
+        if (mode == Mode::Fifo) {
+            uint32_t expected = LOCKED;
+            if (!state.compare_exchange_strong(expected, FREE, memory_order_release, memory_order_relaxed)) {
+                handOff(); // Есть спящие потоки - передаём владение первому
+            }
+        }
+        else if (state.exchange(FREE, memory_order_release) == CONTENDED) {
+            futexWake(&state, 1); // Будим один поток, он соревнуется с остальными
+        }
     }
+
+    // Методы для совместимости с lock_guard
+    void lock() { locker(); }
+    void unlock() { unlocker(); }
+
+private:
+    static constexpr uint32_t FREE = 0; // Монитор свободен
+    static constexpr uint32_t LOCKED = 1; // Монитор захвачен, спящих нет
+    static constexpr uint32_t CONTENDED = 2; // Монитор захвачен, есть спящие
+
+    // Спящий поток в режиме Fifo; узел живёт в стеке ждущего потока
+    struct Waiter {
+        atomic<uint32_t> granted{0}; // Владение передано
+        Waiter* next = nullptr; // Следующий в очереди
+    };
+
+    // Метод для вычисления текущего бюджета активного ожидания
+    uint32_t spinBudget() const {
+        // Ждём примерно два средних удержания: дольше - дешевле уснуть
+        uint64_t budget = 2 * holdEstimate.load(memory_order_relaxed) / pauseCostTicks();
+        if (budget > MAX_SPIN) {
+            return MIN_SPIN; // Удержания длинные: ожидание почти наверняка бесполезно
+        }
+        return static_cast<uint32_t>(max<uint64_t>(budget, MIN_SPIN));
+    }
+
+    // Метод для обновления скользящего среднего времени удержания (вес 1/8)
+    void updateHoldEstimate(uint64_t hold) {
+        uint64_t old = holdEstimate.load(memory_order_relaxed);
+        holdEstimate.store(old - old / 8 + hold / 8, memory_order_relaxed);
+    }
+
+    // Метод медленного пути захвата
+    void lockSlow() {
+        uint32_t budget = spinBudget();
+        for (uint32_t i = 0; i < budget; i++) { // Активное ожидание
+            cpuRelax();
+            uint32_t expected = FREE;
+            if (state.load(memory_order_relaxed) == FREE
+                && state.compare_exchange_weak(expected, LOCKED, memory_order_acquire, memory_order_relaxed)) {
+                return;
+            }
+        }
+        if (mode == Mode::Fifo) {
+            parkInQueue();
+            return;
+        }
+        while (state.exchange(CONTENDED, memory_order_acquire) != FREE) { // Засыпание до освобождения
+            futexWait(&state, CONTENDED);
+        }
+    }
+
+    // Метод для постановки в очередь спящих и ожидания прямой передачи владения
+    void parkInQueue() {
+        Waiter self; // Узел текущего потока
+        {
+            lock_guard<TTASLock> guard(queueLock);
+            uint32_t s = state.load(memory_order_relaxed);
+            while (true) {
+                if (s == FREE) {
+                    if (state.compare_exchange_weak(s, LOCKED, memory_order_acquire, memory_order_relaxed)) {
+                        return; // Монитор освободился, пока брали блокировку очереди
+                    }
+                }
+                else if (s == CONTENDED || state.compare_exchange_weak(s, CONTENDED, memory_order_relaxed)) {
+                    break; // Владелец при освобождении увидит спящих
+                }
+            }
+            if (tail) {
+                tail->next = &self;
+            }
+            else {
+                head = &self;
+            }
+            tail = &self;
+        }
+        while (self.granted.load(memory_order_acquire) == 0) {
+            futexWait(&self.granted, 0); // Сон до передачи владения
+        }
+    }
+
+    // Метод для передачи владения первому потоку в очереди
+    void handOff() {
+        Waiter* next;
+        {
+            lock_guard<TTASLock> guard(queueLock);
+            next = head;
+            head = next->next;
+            if (head == nullptr) {
+                tail = nullptr;
+                state.store(LOCKED, memory_order_relaxed); // Новый владелец - последний спящий
+            }
+        }
+        next->granted.store(1, memory_order_release); // Монитор остаётся захваченным
+        futexWake(&next->granted, 1);
+    }
+
+    Mode mode; // Режим справедливости
+    alignas(CACHE_LINE) atomic<uint32_t> state{FREE}; // Состояние монитора (слово futex)
+    uint64_t acquiredAt = 0; // Момент захвата текущим владельцем
+    atomic<uint64_t> holdEstimate{0}; // Скользящее среднее времени удержания
+    alignas(CACHE_LINE) TTASLock queueLock; // Защита очереди спящих
+    Waiter* head = nullptr; // Первый спящий поток
+    Waiter* tail = nullptr; // Последний спящий поток
+};
+
+// Буфер добавления с отдельным сегментом на каждый поток.
+// Потоки пишут только в свой сегмент, поэтому блокировка не нужна, а
+// сегменты выровнены по строкам кэша, чтобы заголовки векторов не делили строку
+class ShardedAppendBuffer {
+public:
+    // Конструктор
+    ShardedAppendBuffer(int shardCount, size_t reservePerShard = 0) : shards(shardCount) {
+        for (auto& shard : shards) {
+            shard.data.reserve(reservePerShard); // Резерв, чтобы избежать перераспределений
+        }
+    }
+
+    // Метод для добавления символа в сегмент потока
+    void append(int shard, char symbol) {
+        shards[shard].data.push_back(symbol);
+    }
+
+    // Метод для добавления нескольких символов в сегмент потока
+    void append(int shard, const char* symbols, size_t count) {
+        shards[shard].data.insert(shards[shard].data.end(), symbols, symbols + count);
+    }
+
+    // Метод для получения общего количества символов (после завершения записи)
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            total += shard.data.size();
+        }
+        return total;
+    }
+
+    // Метод для обхода всех символов по сегментам без копирования
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const auto& shard : shards) {
+            for (char symbol : shard.data) {
+                visit(symbol);
+            }
+        }
+    }
+
+    // Метод для слияния всех сегментов в один вектор
+    void mergeInto(vector<char>& out) const {
+        out.reserve(out.size() + size());
+        for (const auto& shard : shards) {
+            out.insert(out.end(), shard.data.begin(), shard.data.end());
+        }
+    }
+
+private:
+    // Сегмент одного потока
+    struct alignas(CACHE_LINE) Shard {
+        vector<char> data; // Символы потока
+    };
+
+    vector<Shard> shards; // Сегменты потоков
+};
+
+// Буфер добавления поверх заранее выделенной памяти: поток резервирует
+// место под пакет одним атомарным сдвигом указателя и пишет без блокировки
+class BumpAppendBuffer {
+public:
+    // Конструктор; память принадлежит вызывающему коду
+    BumpAppendBuffer(char* storage, size_t capacity) : storage(storage), capacity(capacity), next(0) {}
+
+    // Метод для резервирования места под count символов; nullptr при переполнении
+    char* reserve(size_t count) {
+        size_t position = next.fetch_add(count, memory_order_relaxed); // Атомарный сдвиг указателя
+        if (position + count > capacity) {
+            return nullptr;
+        }
+        return storage + position;
+    }
+
+    // Метод для добавления пакета символов; false при переполнении
+    bool append(const char* symbols, size_t count) {
+        char* target = reserve(count);
+        if (target == nullptr) {
+            return false;
+        }
+        memcpy(target, symbols, count);
+        return true;
+    }
+
+    // Метод для получения количества записанных символов (после завершения записи)
+    size_t size() const {
+        return min(next.load(memory_order_relaxed), capacity);
+    }
+
+    // Методы для обхода записанных символов
+    const char* begin() const { return storage; }
+    const char* end() const { return storage + size(); }
+
+private:
+    char* storage; // Заранее выделенная память
+    size_t capacity; // Размер памяти
+    alignas(CACHE_LINE) atomic<size_t> next; // Указатель на первое свободное место
+};
+
+// Ограниченная lock-free очередь MPMC на кольцевом буфере (схема Д. Вьюкова).
+// Каждая ячейка хранит номер последовательности: по нему производитель видит,
+// что ячейка свободна, а потребитель - что она заполнена. Ёмкость - степень двойки
+template <typename T>
+class MpmcRing {
+public:
+    // Конструктор
+    MpmcRing(size_t capacity) : mask(capacity - 1), cells(capacity) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw invalid_argument("MpmcRing capacity must be a power of two");
+        }
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, memory_order_relaxed); // Ячейка i свободна для позиции i
+        }
+    }
+
+    // Метод для добавления элемента; false, если очередь заполнена
+    bool try_enqueue(const T& item) {
+        return enqueue_batch(&item, 1) == 1;
+    }
+
+    // Метод для извлечения элемента; false, если очередь пуста
+    bool try_dequeue(T& item) {
+        return dequeue_batch(&item, 1) == 1;
+    }
+
+    // Метод для добавления до count элементов одной операцией над головой; возвращает число добавленных
+    size_t enqueue_batch(const T* items, size_t count) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        while (true) {
+            size_t ready = 0; // Количество подряд идущих свободных ячеек
+            while (ready < count && cells[(pos + ready) & mask].sequence.load(memory_order_acquire) == pos + ready) {
+                ready++;
+            }
+            if (ready == 0) {
+                size_t seq = cells[pos & mask].sequence.load(memory_order_acquire);
+                if (static_cast<intptr_t>(seq - pos) < 0) {
+                    return 0; // Очередь заполнена
+                }
+                pos = enqueuePos.load(memory_order_relaxed); // Позицию уже занял другой производитель
+                continue;
+            }
+            if (enqueuePos.compare_exchange_weak(pos, pos + ready, memory_order_relaxed)) {
+                for (size_t i = 0; i < ready; i++) { // Ячейки принадлежат нам
+                    Cell& cell = cells[(pos + i) & mask];
+                    cell.data = items[i];
+                    cell.sequence.store(pos + i + 1, memory_order_release); // Публикация для потребителя
+                }
+                return ready;
+            }
+        }
+    }
+
+    // Метод для извлечения до count элементов одной операцией над хвостом; возвращает число извлечённых
+    size_t dequeue_batch(T* out, size_t count) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        while (true) {
+            size_t ready = 0; // Количество подряд идущих заполненных ячеек
+            while (ready < count && cells[(pos + ready) & mask].sequence.load(memory_order_acquire) == pos + ready + 1) {
+                ready++;
+            }
+            if (ready == 0) {
+                size_t seq = cells[pos & mask].sequence.load(memory_order_acquire);
+                if (static_cast<intptr_t>(seq - (pos + 1)) < 0) {
+                    return 0; // Очередь пуста
+                }
+                pos = dequeuePos.load(memory_order_relaxed); // Позицию уже занял другой потребитель
+                continue;
+            }
+            if (dequeuePos.compare_exchange_weak(pos, pos + ready, memory_order_relaxed)) {
+                for (size_t i = 0; i < ready; i++) { // Ячейки принадлежат нам
+                    Cell& cell = cells[(pos + i) & mask];
+                    out[i] = cell.data;
+                    cell.sequence.store(pos + i + mask + 1, memory_order_release); // Ячейка свободна на следующем круге
+                }
+                return ready;
+            }
+        }
+    }
+
+private:
+    // Ячейка кольцевого буфера
+    struct Cell {
+        atomic<size_t> sequence; // Номер последовательности
+        T data; // Элемент
+    };
+
+    size_t mask; // Ёмкость минус один
+    vector<Cell> cells; // Кольцевой буфер
+    alignas(CACHE_LINE) atomic<size_t> enqueuePos{0}; // Голова: позиция следующей записи
+    alignas(CACHE_LINE) atomic<size_t> dequeuePos{0}; // Хвост: позиция следующего чтения
+};
+
+// Ограниченная очередь на кольцевом буфере, защищённая блокировкой LockType
+template <typename T, typename LockType>
+class LockedQueue {
+public:
+    // Конструктор
+    LockedQueue(size_t capacity) : buffer(capacity), head(0), count(0) {}
+
+    // Метод для добавления до n элементов под одним захватом блокировки
+    size_t enqueue_batch(const T* items, size_t n) {
+        lock_guard<LockType> lock(guard);
+        size_t accepted = min(n, buffer.size() - count); // Сколько помещается
+        for (size_t i = 0; i < accepted; i++) {
+            buffer[(head + count + i) % buffer.size()] = items[i];
+        }
+        count += accepted;
+        return accepted;
+    }
+
+    // Метод для извлечения до n элементов под одним захватом блокировки
+    size_t dequeue_batch(T* out, size_t n) {
+        lock_guard<LockType> lock(guard);
+        size_t taken = min(n, count); // Сколько есть
+        for (size_t i = 0; i < taken; i++) {
+            out[i] = buffer[(head + i) % buffer.size()];
+        }
+        head = (head + taken) % buffer.size();
+        count -= taken;
+        return taken;
+    }
+
+private:
+    LockType guard; // Блокировка очереди
+    vector<T> buffer; // Кольцевой буфер
+    size_t head; // Индекс первого элемента
+    size_t count; // Количество элементов
+};
+
+// Адаптеры, приводящие примитивы к интерфейсу lock()/unlock() для lock_guard
+struct SemaphoreLock {
+    Semaphore sem{1}; // Двоичный семафор
+    void lock() { sem.acquire(); }
+    void unlock() { sem.release(); }
+};
+
+struct SemaphoreSlimLock {
+    SemaphoreSlim sem{1, 1}; // Двоичный упрощенный семафор
+    void lock() { sem.acquire(); }
+    void unlock() { sem.release(); }
+};
+
+struct MonitorLock {
+    Monitor monitor; // Монитор
+    void lock() { monitor.locker(); }
+    void unlock() { monitor.unlocker(); }
+};
+
+struct FlagSpinLock {
+    atomic_flag flag = ATOMIC_FLAG_INIT; // Флаг спинлока
+    void lock() { while (flag.test_and_set(memory_order_acquire)) {} }
+    void unlock() { flag.clear(memory_order_release); }
+};
+
+// Рабочие функции потоков получают заранее сгенерированные символы,
+// поэтому замер отражает стоимость синхронизации, а не генерации
+
+// Функция для работы с мьютексом
+template <typename MutexType>
+void threadMutex(MutexType& mtx, vector<char>& allSymbols, const char* symbols, int iterations) { 
+    for (int i = 0; i < iterations; i++) { 
+        lock_guard<MutexType> lock(mtx); // Захват мьютекса
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+    }
+}
+
+// Функция для работы с семафором
+template <typename SemaphoreType>
+void threadSemaphore(SemaphoreType& sem, vector<char>& allSymbols, const char* symbols, int iterations) { 
+    for (int i = 0; i < iterations; i++) {
+        sem.acquire(); // Захват семафора
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+        sem.release(); // Освобождение семафора
+    }
+}
+
+// Функция для работы с упрощенным семафором
+template <typename SemaphoreType>
+void threadSemaphoreSlim(SemaphoreType& semSlim, vector<char>& allSymbols, const char* symbols, int iterations) { 
+    for (int i = 0; i < iterations; i++) {
+        semSlim.acquire(); // Захват семафора
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+        semSlim.release(); // Освобождение семафора
+    }
+}
+
+// Функция для работы с барьером (любой класс с методом wait(int))
+// После барьера потоки пишут одновременно, поэтому каждый поток пишет в свою ячейку фазы i.
+// Номер потока известен, поэтому барьерам с номерами участников не нужен реестр
+template <typename BarrierType>
+void threadBarrier(BarrierType& barrier, vector<char>& allSymbols, const char* symbols, int threadIndex, int threadCount, int iterations) { 
+    for (int i = 0; i < iterations; i++) {
+        barrier.wait(threadIndex); // Ожидание достижения барьера
+        allSymbols[static_cast<size_t>(i) * threadCount + threadIndex] = symbols[i]; // Запись символа в ячейку потока
+    }
+}
+
+// Функция для работы с монитором
+template <typename MonitorType>
+void threadMonitor(MonitorType& monitor, vector<char>& allSymbols, const char* symbols, int iterations) { 
+    for (int i = 0; i < iterations; i++) {
+        monitor.locker(); // Захват монитора
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+        monitor.unlocker(); // Освобождение монитора
+    }
+}
+
+// Функция для работы со спинлоком
+template <typename FlagType>
+void threadSpinLock(FlagType& spinLock, vector<char>& allSymbols, const char* symbols, int iterations) { 
+    for (int i = 0; i < iterations; i++) {
+        while (spinLock.test_and_set(memory_order_acquire)) {} // Ожидание, пока флаг не будет сброшен
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+        spinLock.clear(memory_order_release); // Сброс флага
+    }
+}
+
+// Функция для работы с блокировкой, совместимой с lock_guard
+template <typename LockType>
+void threadLock(LockType& spinLock, vector<char>& allSymbols, const char* symbols, int iterations) {
+    for (int i = 0; i < iterations; i++) {
+        lock_guard<LockType> lock(spinLock); // Захват блокировки
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+    }
+}
+
+const size_t APPEND_BATCH = 64; // Размер пакета, резервируемого в BumpAppendBuffer
+
+// Функция для записи без блокировки в сегмент потока
+void threadSharded(ShardedAppendBuffer& buffer, int threadIndex, const char* symbols, int iterations) {
+    for (int i = 0; i < iterations; i++) {
+        buffer.append(threadIndex, symbols[i]); // Добавление символа в свой сегмент
+    }
+}
+
+// Функция для записи без блокировки пакетами через атомарный указатель
+void threadBump(BumpAppendBuffer& buffer, const char* symbols, int iterations) {
+    for (size_t i = 0; i < static_cast<size_t>(iterations); i += APPEND_BATCH) {
+        size_t count = min(APPEND_BATCH, static_cast<size_t>(iterations) - i); // Размер пакета
+        buffer.append(symbols + i, count); // Резервирование и копирование пакета
+    }
+}
+
+// Функция для работы с спин-ожиданием
+template <typename FlagType>
+void threadSpinWait(FlagType& spinLock, vector<char>& allSymbols, const char* symbols, int iterations) { 
+    for (int i = 0; i < iterations; i++) {
+        while (spinLock.test_and_set(memory_order_acquire)) { // Ожидание, пока флаг не будет сброшен
+            this_thread::yield(); // Передача управления другим потокам
+        }
+        allSymbols.push_back(symbols[i]); // Добавление символа в вектор
+        spinLock.clear(memory_order_release); // Сброс флага
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Инструментирование конкуренции
+// ---------------------------------------------------------------------------
+
+using BenchClock = chrono::steady_clock; // Монотонные часы для замеров
+
+// Функция для получения текущего времени в наносекундах
+inline int64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(BenchClock::now().time_since_epoch()).count();
+}
+
+// Гистограмма задержек с логарифмически-линейными корзинами (в духе HDR Histogram):
+// в каждой степени двойки 32 корзины, поэтому относительная погрешность не больше 1/32,
+// а запись значения - O(1) без выделения памяти
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5; // Бит точности внутри степени двойки
+    static constexpr int SUB_COUNT = 1 << SUB_BITS; // Корзин на степень двойки
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT; // Всего корзин
+
+    LatencyHistogram() : counts(BUCKETS, 0), total(0), sum(0), maxValue(0) {}
+
+    // Метод для записи значения (в наносекундах)
+    void record(int64_t value) {
+        uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+        counts[indexOf(v)]++;
+        total++;
+        sum += v;
+        maxValue = max(maxValue, v);
+    }
+
+    // Метод для добавления значений другой гистограммы
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        maxValue = max(maxValue, other.maxValue);
+    }
+
+    // Метод для получения количества записанных значений
+    uint64_t count() const {
+        return total;
+    }
+
+    // Метод для получения среднего значения
+    double mean() const {
+        return total ? static_cast<double>(sum) / total : 0.0;
+    }
+
+    // Метод для получения максимального значения
+    uint64_t maximum() const {
+        return maxValue;
+    }
+
+    // Метод для получения перцентиля (середина корзины, не больше максимума)
+    double percentile(double p) const {
+        if (total == 0) {
+            return 0.0;
+        }
+        uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(p * total))); // Ранг значения
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                double mid = lowerBound(i) + (widthOf(i) - 1) / 2.0;
+                return min(mid, static_cast<double>(maxValue));
+            }
+        }
+        return static_cast<double>(maxValue);
+    }
+
+private:
+    // Функция для вычисления индекса корзины
+    static int indexOf(uint64_t v) {
+        if (v < static_cast<uint64_t>(SUB_COUNT)) {
+            return static_cast<int>(v); // Малые значения - точные корзины
+        }
+        int e = 63 - __builtin_clzll(v); // Старший бит
+        return (e - SUB_BITS + 1) * SUB_COUNT + static_cast<int>((v >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+
+    // Функция для вычисления нижней границы корзины
+    static uint64_t lowerBound(int index) {
+        if (index < SUB_COUNT) {
+            return index;
+        }
+        int e = index / SUB_COUNT + SUB_BITS - 1;
+        return (static_cast<uint64_t>(SUB_COUNT) + index % SUB_COUNT) << (e - SUB_BITS);
+    }
+
+    // Функция для вычисления ширины корзины
+    static uint64_t widthOf(int index) {
+        if (index < SUB_COUNT) {
+            return 1;
+        }
+        return 1ULL << (index / SUB_COUNT - 1);
+    }
+
+    vector<uint64_t> counts; // Счётчики корзин
+    uint64_t total; // Количество значений
+    uint64_t sum; // Сумма значений
+    uint64_t maxValue; // Максимальное значение
+};
+
+// Счётчики конкуренции одного потока
+struct alignas(CACHE_LINE) ThreadContention {
+    uint64_t acquisitions = 0; // Количество захватов или проходов барьера
+    LatencyHistogram waitNs; // Время ожидания захвата, нс
+    LatencyHistogram holdNs; // Время удержания, нс
+    uint64_t futexWaits = 0; // Засыпаний на futex
+    uint64_t voluntarySwitches = 0; // Добровольных переключений контекста (парковок в ядре)
+    int64_t holdStart = 0; // Момент последнего захвата
+};
+
+thread_local ThreadContention* currentContention = nullptr; // Счётчики текущего потока (nullptr - не собирать)
+
+// Функция для получения числа добровольных переключений контекста текущего потока
+inline uint64_t voluntarySwitches() {
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return static_cast<uint64_t>(usage.ru_nvcsw);
+}
+
+// Политика без инструментирования: обёртки не создаются, используются сами примитивы
+struct NoInstrumentation {
+    static constexpr bool enabled = false;
+};
+
+// Политика сбора времени ожидания и удержания в счётчики текущего потока
+struct ContentionInstrumentation {
+    static constexpr bool enabled = true;
+
+    // Метод для получения текущего времени
+    static int64_t now() {
+        return nowNs();
+    }
+
+    // Метод, вызываемый после захвата; start - момент начала ожидания
+    static void onAcquire(int64_t start) {
+        ThreadContention* c = currentContention;
+        if (c) {
+            int64_t acquired = now();
+            c->acquisitions++;
+            c->waitNs.record(acquired - start);
+            c->holdStart = acquired;
+        }
+    }
+
+    // Метод, вызываемый перед освобождением
+    static void onRelease() {
+        ThreadContention* c = currentContention;
+        if (c) {
+            c->holdNs.record(now() - c->holdStart);
+        }
+    }
+
+    // Метод, вызываемый после прохода барьера; start - момент прихода к барьеру
+    static void onBarrier(int64_t start) {
+        ThreadContention* c = currentContention;
+        if (c) {
+            c->acquisitions++;
+            c->waitNs.record(now() - start);
+        }
+    }
+};
+
+// Выбор типа: обёртка при включённом инструментировании, иначе сам примитив,
+// поэтому сборка без инструментирования не несёт никаких накладных расходов
+template <template <typename, typename> class Wrapper, typename T, typename Policy>
+using Instrument = typename conditional<Policy::enabled, Wrapper<T, Policy>, T>::type;
+
+// Обёртка для блокировок с методами lock()/unlock()
+template <typename LockType, typename Policy>
+class InstrumentedLock {
+public:
+    template <typename... Args>
+    InstrumentedLock(Args&&... args) : inner(forward<Args>(args)...) {}
+
+    void lock() {
+        int64_t start = Policy::now();
+        inner.lock();
+        Policy::onAcquire(start);
+    }
+
+    void unlock() {
+        Policy::onRelease();
+        inner.unlock();
+    }
+
+private:
+    LockType inner; // Исходная блокировка
+};
+
+// Обёртка для семафоров с методами acquire()/release()
+template <typename SemaphoreType, typename Policy>
+class InstrumentedSemaphore {
+public:
+    template <typename... Args>
+    InstrumentedSemaphore(Args&&... args) : inner(forward<Args>(args)...) {}
+
+    void acquire() {
+        int64_t start = Policy::now();
+        inner.acquire();
+        Policy::onAcquire(start);
+    }
+
+    auto release() {
+        Policy::onRelease();
+        return inner.release();
+    }
+
+private:
+    SemaphoreType inner; // Исходный семафор
+};
+
+// Обёртка для монитора с методами locker()/unlocker()
+template <typename MonitorType, typename Policy>
+class InstrumentedMonitor {
+public:
+    template <typename... Args>
+    InstrumentedMonitor(Args&&... args) : inner(forward<Args>(args)...) {}
+
+    void locker() {
+        int64_t start = Policy::now();
+        inner.locker();
+        Policy::onAcquire(start);
+    }
+
+    void unlocker() {
+        Policy::onRelease();
+        inner.unlocker();
+    }
+
+private:
+    MonitorType inner; // Исходный монитор
+};
+
+// Обёртка для барьеров с методом wait()
+template <typename BarrierType, typename Policy>
+class InstrumentedBarrier {
+public:
+    template <typename... Args>
+    InstrumentedBarrier(Args&&... args) : inner(forward<Args>(args)...) {}
+
+    void wait() {
+        int64_t start = Policy::now();
+        inner.wait();
+        Policy::onBarrier(start);
+    }
+
+    // Номер потока передаётся дальше, чтобы в замер не попадал поиск в реестре
+    void wait(int threadIndex) {
+        int64_t start = Policy::now();
+        inner.wait(threadIndex);
+        Policy::onBarrier(start);
+    }
+
+private:
+    BarrierType inner; // Исходный барьер
+};
+
+// Обёртка для atomic_flag, используемого как спинлок: ожидание отсчитывается
+// от первой неудачной попытки test_and_set до удачной
+template <typename FlagType, typename Policy>
+class InstrumentedFlag {
+public:
+    bool test_and_set(memory_order order = memory_order_seq_cst) {
+        if (waitStart == 0) {
+            waitStart = Policy::now(); // Первая попытка захвата
+        }
+        bool busy = inner.test_and_set(order);
+        if (!busy) {
+            Policy::onAcquire(waitStart);
+            waitStart = 0;
+        }
+        return busy;
+    }
+
+    void clear(memory_order order = memory_order_seq_cst) {
+        Policy::onRelease();
+        inner.clear(order);
+    }
+
+private:
+    static thread_local int64_t waitStart; // Начало ожидания текущего потока
+    FlagType inner = ATOMIC_FLAG_INIT; // Исходный флаг
+};
+
+template <typename FlagType, typename Policy>
+thread_local int64_t InstrumentedFlag<FlagType, Policy>::waitStart = 0;
+
+// Аппаратные и программные счётчики perf_event_open для всего прогона.
+// Счётчики открываются с наследованием до создания потоков, поэтому учитывают все
+// рабочие потоки; если ядро не разрешает их открыть, значения недоступны
+class PerfCounters {
+public:
+    static constexpr int COUNT = 3; // Циклы, промахи кэша, переключения контекста
+
+    PerfCounters() {
+        fds[0] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[1] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[2] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Метод для запуска счёта
+    void enable() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    // Метод для остановки счёта
+    void disable() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    // Метод для чтения счётчика; -1, если он недоступен
+    int64_t read(int index) const {
+        uint64_t value = 0;
+        if (fds[index] < 0 || ::read(fds[index], &value, sizeof(value)) != sizeof(value)) {
+            return -1;
+        }
+        return static_cast<int64_t>(value);
+    }
+
+private:
+    // Функция для открытия одного счётчика; -1 при ошибке
+    static int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1; // Включается перед стартом прогона
+        attr.inherit = 1; // Учитывать потоки, созданные после открытия
+        attr.exclude_hv = 1;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0) {
+            attr.exclude_kernel = 1; // При perf_event_paranoid >= 2 доступен только режим пользователя
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        return fd;
+    }
+
+    int fds[COUNT]; // Дескрипторы счётчиков
+};
+
+// Данные инструментирования одного прогона
+struct TrialContention {
+    vector<ThreadContention> threads; // Счётчики потоков
+    int64_t perf[PerfCounters::COUNT] = {-1, -1, -1}; // Значения perf-счётчиков за прогон
+};
+
+// Сводка инструментирования по серии прогонов
+struct ContentionSummary {
+    double acquisitionsPerTrial = 0; // Захватов за прогон
+    double fairness = 0; // Отношение минимального числа захватов потока к максимальному
+    double waitP50 = 0, waitP99 = 0, waitMax = 0; // Время ожидания, нс
+    double holdP50 = 0, holdP99 = 0; // Время удержания, нс
+    double futexWaitsPerTrial = 0; // Засыпаний на futex за прогон
+    double parksPerTrial = 0; // Добровольных переключений контекста за прогон
+    double perfPerTrial[PerfCounters::COUNT] = {-1, -1, -1}; // Среднее perf-счётчиков (-1 - недоступно)
+};
+
+// Функция для сведения данных инструментирования серии прогонов
+ContentionSummary summarizeContention(const vector<TrialContention>& trials) {
+    ContentionSummary summary;
+    if (trials.empty()) {
+        return summary;
+    }
+    LatencyHistogram waits, holds; // Объединённые гистограммы
+    vector<uint64_t> perThread(trials.front().threads.size(), 0); // Захваты по номерам потоков
+    uint64_t acquisitions = 0, futexWaits = 0, parks = 0;
+    double perfSum[PerfCounters::COUNT] = {0, 0, 0};
+    bool perfOk[PerfCounters::COUNT] = {true, true, true};
+    for (const auto& trial : trials) {
+        for (size_t t = 0; t < trial.threads.size(); t++) {
+            const auto& c = trial.threads[t];
+            waits.merge(c.waitNs);
+            holds.merge(c.holdNs);
+            perThread[t] += c.acquisitions;
+            acquisitions += c.acquisitions;
+            futexWaits += c.futexWaits;
+            parks += c.voluntarySwitches;
+        }
+        for (int k = 0; k < PerfCounters::COUNT; k++) {
+            perfOk[k] = perfOk[k] && trial.perf[k] >= 0;
+            perfSum[k] += static_cast<double>(trial.perf[k]);
+        }
+    }
+    double n = static_cast<double>(trials.size());
+    summary.acquisitionsPerTrial = acquisitions / n;
+    auto range = minmax_element(perThread.begin(), perThread.end());
+    summary.fairness = *range.second ? static_cast<double>(*range.first) / *range.second : 1.0;
+    summary.waitP50 = waits.percentile(0.50);
+    summary.waitP99 = waits.percentile(0.99);
+    summary.waitMax = static_cast<double>(waits.maximum());
+    summary.holdP50 = holds.percentile(0.50);
+    summary.holdP99 = holds.percentile(0.99);
+    summary.futexWaitsPerTrial = futexWaits / n;
+    summary.parksPerTrial = parks / n;
+    for (int k = 0; k < PerfCounters::COUNT; k++) {
+        summary.perfPerTrial[k] = perfOk[k] ? perfSum[k] / n : -1;
+    }
+    return summary;
+}
+
+// ---------------------------------------------------------------------------
+// Топология процессора и размещение потоков
+// ---------------------------------------------------------------------------
+
+// Описание логического процессора
+struct CpuInfo {
+    int cpu; // Номер логического процессора
+    int core; // Номер физического ядра внутри сокета
+    int package; // Номер сокета
+    int node; // Номер узла NUMA
+    int sibling; // Порядковый номер среди SMT-соседей того же ядра
+};
+
+// Политика размещения потоков
+enum class Placement { None, Compact, Spread, Sockets };
+
+vector<int> placementCpus; // Процессоры для потоков по порядку (пусто - без закрепления)
+
+// Функция для чтения целого числа из файла sysfs; fallback при ошибке
+int readSysfsInt(const string& path, int fallback) {
+    ifstream in(path);
+    int value;
+    return in >> value ? value : fallback;
+}
+
+// Функция для чтения топологии процессоров, доступных процессу, из /sys/devices/system/cpu
+vector<CpuInfo> readCpuTopology() {
+    cpu_set_t allowed; // Процессоры, на которых процессу разрешено выполняться
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &allowed);
+        }
+    }
+    vector<CpuInfo> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        string base = "/sys/devices/system/cpu/cpu" + to_string(cpu);
+        if (!CPU_ISSET(cpu, &allowed) || access(base.c_str(), F_OK) != 0) {
+            continue;
+        }
+        CpuInfo info{cpu, readSysfsInt(base + "/topology/core_id", cpu),
+                     readSysfsInt(base + "/topology/physical_package_id", 0), 0, 0};
+        if (DIR* dir = opendir(base.c_str())) { // Узел NUMA виден как подкаталог nodeN
+            while (dirent* entry = readdir(dir)) {
+                if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(static_cast<unsigned char>(entry->d_name[4]))) {
+                    info.node = atoi(entry->d_name + 4);
+                }
+            }
+            closedir(dir);
+        }
+        cpus.push_back(info);
+    }
+    for (auto& info : cpus) { // Номер среди SMT-соседей: процессоры ядра по возрастанию номера
+        for (const auto& other : cpus) {
+            if (other.package == info.package && other.core == info.core && other.cpu < info.cpu) {
+                info.sibling++;
+            }
+        }
+    }
+    return cpus;
+}
+
+// Функция для построения порядка процессоров по политике размещения:
+// поток i закрепляется за процессором order[i % order.size()]
+vector<int> placementOrder(vector<CpuInfo> cpus, Placement placement) {
+    if (placement == Placement::None) {
+        return {};
+    }
+    map<pair<int, int>, int> coreRank; // Порядковый номер ядра внутри узла NUMA
+    map<int, int> coresInNode; // Количество ядер в узле
+    for (const auto& info : cpus) {
+        if (info.sibling == 0) {
+            coreRank[{info.node, info.package * 100000 + info.core}] = coresInNode[info.node]++;
+        }
+    }
+    auto rankOf = [&](const CpuInfo& info) { return coreRank[{info.node, info.package * 100000 + info.core}]; };
+    sort(cpus.begin(), cpus.end(), [&](const CpuInfo& a, const CpuInfo& b) {
+        if (placement == Placement::Compact) { // Сначала SMT-соседи одного ядра, затем соседние ядра
+            return make_tuple(a.node, a.package, a.core, a.sibling) < make_tuple(b.node, b.package, b.core, b.sibling);
+        }
+        if (placement == Placement::Spread) { // По одному потоку на физическое ядро, затем SMT-соседи
+            return make_tuple(a.sibling, a.node, a.package, a.core) < make_tuple(b.sibling, b.node, b.package, b.core);
+        }
+        // Sockets: поочерёдно по узлам NUMA, внутри узла - по ядрам, SMT-соседи в конце
+        return make_tuple(a.sibling, rankOf(a), a.node) < make_tuple(b.sibling, rankOf(b), b.node);
+    });
+    vector<int> order;
+    for (const auto& info : cpus) {
+        order.push_back(info.cpu);
+    }
+    return order;
+}
+
+// Функция для закрепления текущего потока за процессором по номеру потока
+void pinCurrentThread(int threadIndex) {
+    if (placementCpus.empty()) {
+        return; // Размещение выбирает планировщик
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(placementCpus[threadIndex % placementCpus.size()], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Функция для построения набора количеств потоков от 1 до 4 x числа процессоров:
+// степени двойки плюс точные кратные числа процессоров
+vector<int> sweepThreadCounts(int cpuCount) {
+    set<int> counts;
+    for (int n = 1; n <= 4 * cpuCount; n *= 2) {
+        counts.insert(n);
+    }
+    for (int k = 1; k <= 4; k++) {
+        counts.insert(k * cpuCount);
+    }
+    return vector<int>(counts.begin(), counts.end());
+}
+
+// Функция для вывода обнаруженной топологии
+void printTopology(const vector<CpuInfo>& cpus) {
+    cout << "cpu,core,package,node,smt_sibling\n";
+    for (const auto& info : cpus) {
+        cout << info.cpu << ',' << info.core << ',' << info.package << ',' << info.node << ',' << info.sibling << '\n';
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Измерительный стенд
+// ---------------------------------------------------------------------------
+
+// Стартовые ворота: потоки создаются заранее и ждут общего сигнала,
+// поэтому стоимость создания потоков не попадает в замер
+class StartGate {
+public:
+    StartGate(int count) : expected(count), arrived(0), opened(false) {}
+
+    // Метод, вызываемый потоком: отметиться и ждать открытия ворот
+    void arrive() {
+        arrived.fetch_add(1, memory_order_acq_rel); // Поток готов к старту
+        while (!opened.load(memory_order_acquire)) { // Ожидание открытия ворот
+            this_thread::yield(); // Передача управления другим потокам
+        }
+    }
+
+    // Метод, вызываемый главным потоком: дождаться готовности всех потоков
+    void waitForAll() {
+        while (arrived.load(memory_order_acquire) < expected) { // Ожидание всех потоков
+            this_thread::yield(); // Передача управления другим потокам
+        }
+    }
+
+    // Метод для открытия ворот
+    void open() {
+        opened.store(true, memory_order_release); // Сигнал старта
+    }
+
+private:
+    int expected; // Количество ожидаемых потоков
+    atomic<int> arrived; // Количество потоков, подошедших к воротам
+    atomic<bool> opened; // Признак открытия ворот
+};
+
+using ThreadBody = function<void(int, const char*)>; // Тело потока, получает номер потока и его символы
+
+// Описание тестируемого примитива
+struct BenchCase {
+    string name; // Имя примитива в отчёте
+    // Подготовка одного прогона: создаёт примитив на заданное число потоков
+    // и возвращает тело потока; вызывается вне замера
+    function<ThreadBody(int threadCount, int iterations, vector<char>& allSymbols)> prepare;
+};
+
+// Параметры запуска бенчмарка
+struct BenchConfig {
+    vector<int> threadCounts{4}; // Перебираемые количества потоков
+    int iterations = N; // Количество итераций на поток
+    int repetitions = 10; // Количество замеряемых прогонов
+    int warmups = 2; // Количество прогревочных прогонов
+    string format = "text"; // Формат отчёта: text, csv или json
+    vector<string> only; // Имена примитивов для запуска (пусто - все)
+    RngKind rng = RngKind::Xoshiro; // Генератор символов
+    uint64_t seed = 0; // Зерно генератора (0 - случайное)
+    string mode = "locks"; // Режим: locks или pc (производитель/потребитель)
+    int producers = 2; // Генераторов в режиме pc
+    int consumers = 2; // Потребителей в режиме pc
+    int batch = 1; // Размер пакета в режиме pc
+    int capacity = 1024; // Ёмкость очереди в режиме pc
+    bool instrument = false; // Собирать счётчики конкуренции
+    Placement placement = Placement::None; // Политика закрепления потоков
+    bool sweep = false; // Перебор количества потоков от 1 до 4 x числа процессоров
+    bool showTopology = false; // Только вывести топологию
+};
+
+// Статистика по серии прогонов
+struct BenchStats {
+    double median, p90, p99, mean, stddev, minimum, maximum; // Секунды
+};
+
+// Результат серии прогонов одного примитива
+struct BenchResult {
+    string name; // Имя примитива
+    int threadCount = 0; // Количество потоков
+    string placement = "none"; // Политика закрепления потоков
+    int cpus = 0; // Доступных логических процессоров
+    int producers = 0; // Генераторов (только в режиме производитель/потребитель)
+    int consumers = 0; // Потребителей (только в режиме производитель/потребитель)
+    int iterations = 0; // Итераций на поток
+    int repetitions = 0; // Количество прогонов
+    size_t items = 0; // Элементов за один прогон
+    BenchStats stats; // Статистика времени прогона
+    bool hasLatency = false; // Измерялась ли задержка элементов
+    double latencyP50 = 0, latencyP90 = 0, latencyP99 = 0; // Перцентили задержки, нс
+    bool hasContention = false; // Собиралось ли инструментирование
+    ContentionSummary contention; // Сводка инструментирования
+    bool valid = true; // Все прогоны записали ровно выданные потоками символы
+};
+
+// Гистограмма символов: сколько раз встречается каждое значение байта
+using SymbolCounts = array<size_t, 256>;
+
+void countSymbols(const char* symbols, size_t count, SymbolCounts& counts) {
+    for (size_t i = 0; i < count; i++) {
+        counts[static_cast<unsigned char>(symbols[i])]++;
+    }
+}
+
+// Функция для проверки результата прогона: вектор содержит ровно те символы,
+// которые выдали потоки (как мультимножество). Размер сам по себе ничего не
+// доказывает - барьеры и BumpBuffer заранее делают resize, а незаписанные
+// ячейки остаются нулевыми и дают расхождение в счётчике нулевого байта
+bool sameSymbols(const vector<char>& allSymbols, const vector<SymbolCounts>& emitted) {
+    SymbolCounts expected{}, actual{};
+    for (const auto& counts : emitted) {
+        for (size_t c = 0; c < expected.size(); c++) {
+            expected[c] += counts[c];
+        }
+    }
+    countSymbols(allSymbols.data(), allSymbols.size(), actual);
+    return expected == actual;
+}
+
+// Функция для выполнения одного прогона; возвращает время в секундах.
+// Если передан contention, собираются счётчики конкуренции потоков и perf-счётчики
+double runTrial(const BenchCase& bench, int threadCount, int iterations, bool& valid, TrialContention* contention = nullptr) {
+    vector<char> allSymbols; // Новый вектор на каждый прогон, чтобы условия совпадали
+    ThreadBody body = bench.prepare(threadCount, iterations, allSymbols); // Подготовка примитива
+    StartGate gate(threadCount); // Стартовые ворота
+    vector<BenchClock::time_point> finished(threadCount); // Время завершения каждого потока
+    vector<SymbolCounts> emitted(threadCount, SymbolCounts{}); // Символы каждого потока для проверки
+    unique_ptr<PerfCounters> perf; // perf-счётчики открываются до создания потоков
+    if (contention) {
+        contention->threads = vector<ThreadContention>(threadCount);
+        perf.reset(new PerfCounters);
+    }
+    vector<thread> threads; // Вектор потоков
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&, i]() {
+            pinCurrentThread(i); // Закрепление до первого касания памяти
+            vector<char> symbols(iterations); // Символы потока
+            fillRandomSymbols(symbols.data(), symbols.size()); // Пакетная генерация до старта
+            countSymbols(symbols.data(), symbols.size(), emitted[i]); // Подсчёт вне замера
+            MCSLock::prepareThread(); // Узлы очередных блокировок создаются вне замера
+            CLHLock::prepareThread();
+            ThreadContention* mine = contention ? &contention->threads[i] : nullptr; // Счётчики потока
+            uint64_t futexBefore = futexWaitCount; // Засыпания до старта
+            uint64_t switchesBefore = mine ? voluntarySwitches() : 0; // Переключения до старта
+            gate.arrive(); // Ожидание общего старта
+            currentContention = mine;
+            body(i, symbols.data()); // Полезная работа
+            finished[i] = BenchClock::now(); // Фиксация времени завершения
+            currentContention = nullptr;
+            if (mine) {
+                mine->futexWaits = futexWaitCount - futexBefore;
+                mine->voluntarySwitches = voluntarySwitches() - switchesBefore;
+            }
+        });
+    }
+    gate.waitForAll(); // Все потоки созданы и ждут
+    if (perf) {
+        perf->enable(); // Счёт только на время прогона
+    }
+    auto start = BenchClock::now(); // Запуск таймера
+    gate.open(); // Старт
     for (auto& t : threads) {
         t.join(); // Ожидание завершения потоков
     }
-    end = chrono::high_resolution_clock::now(); // Завершение таймера
-    elapsed = end - start; // Вычисление времени выполнения
-    cout << "Monitor time: " << elapsed.count() << " seconds\n"; // Вывод времени выполнения
+    if (perf) {
+        perf->disable();
+        for (int k = 0; k < PerfCounters::COUNT; k++) {
+            contention->perf[k] = perf->read(k);
+        }
+    }
+    auto end = *max_element(finished.begin(), finished.end()); // Завершение последнего потока
+    valid = allSymbols.size() == static_cast<size_t>(threadCount) * iterations && sameSymbols(allSymbols, emitted); // Проверка содержимого
+    return chrono::duration<double>(end - start).count(); // Время выполнения
+}
+
+// Функция для вычисления перцентиля по отсортированной выборке (метод ближайшего ранга)
+double percentile(const vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(ceil(p * sorted.size())); // Ранг элемента
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Функция для вычисления статистики по выборке
+BenchStats computeStats(vector<double> samples) {
+    sort(samples.begin(), samples.end()); // Сортировка для перцентилей
+    BenchStats stats;
+    size_t n = samples.size();
+    stats.minimum = samples.front();
+    stats.maximum = samples.back();
+    stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    stats.p90 = percentile(samples, 0.90);
+    stats.p99 = percentile(samples, 0.99);
+    stats.mean = accumulate(samples.begin(), samples.end(), 0.0) / n;
+    double sq = 0; // Сумма квадратов отклонений
+    for (double s : samples) {
+        sq += (s - stats.mean) * (s - stats.mean);
+    }
+    stats.stddev = n > 1 ? sqrt(sq / (n - 1)) : 0.0; // Выборочное стандартное отклонение
+    return stats;
+}
+
+// Функция для выполнения серии прогонов одного примитива
+BenchResult runBenchmark(const BenchCase& bench, int threadCount, const BenchConfig& config) {
+    bool valid = true; // Признак корректности всех прогонов
+    bool trialValid; // Признак корректности одного прогона
+    for (int i = 0; i < config.warmups; i++) {
+        runTrial(bench, threadCount, config.iterations, trialValid); // Прогрев, результат отбрасывается
+        valid = valid && trialValid;
+    }
+    vector<double> samples; // Замеры времени
+    vector<TrialContention> contention(config.instrument ? config.repetitions : 0); // Счётчики прогонов
+    for (int i = 0; i < config.repetitions; i++) {
+        TrialContention* trial = config.instrument ? &contention[i] : nullptr;
+        samples.push_back(runTrial(bench, threadCount, config.iterations, trialValid, trial));
+        valid = valid && trialValid;
+    }
+    BenchResult result;
+    result.name = bench.name;
+    result.threadCount = threadCount;
+    result.iterations = config.iterations;
+    result.repetitions = config.repetitions;
+    result.items = static_cast<size_t>(threadCount) * config.iterations;
+    result.stats = computeStats(samples);
+    result.hasContention = config.instrument;
+    result.contention = summarizeContention(contention);
+    result.valid = valid;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Режим производитель/потребитель
+// ---------------------------------------------------------------------------
+
+// Элемент очереди: символ и момент постановки в очередь
+struct QueueItem {
+    char symbol; // Символ
+    int64_t enqueuedNs; // Время постановки в очередь, нс
+};
+
+// Параметры режима производитель/потребитель
+struct PcParams {
+    int producers; // Количество потоков-генераторов
+    int consumers; // Количество потоков-потребителей
+    int iterations; // Символов на генератор
+    int batch; // Размер пакета при записи и чтении
+    size_t capacity; // Ёмкость очереди
+};
+
+// Описание тестируемой очереди
+struct PcCase {
+    string name; // Имя очереди в отчёте
+    // Один прогон: возвращает время в секундах, дополняет гистограмму задержек
+    function<double(const PcParams& params, LatencyHistogram& latency, bool& valid)> run;
+};
+
+// Функция для выполнения одного прогона: генераторы отдают символы в очередь,
+// потребители забирают их и записывают задержку от постановки до извлечения
+template <typename QueueType>
+double runPcTrial(const PcParams& params, LatencyHistogram& latency, bool& valid) {
+    QueueType queue(params.capacity); // Очередь
+    int threadCount = params.producers + params.consumers; // Всего потоков
+    size_t total = static_cast<size_t>(params.producers) * params.iterations; // Всего элементов
+    size_t batch = static_cast<size_t>(params.batch); // Размер пакета
+    atomic<size_t> consumed{0}; // Количество извлечённых элементов
+    atomic<uint64_t> producedSum{0}, consumedSum{0}; // Контрольные суммы символов
+    vector<LatencyHistogram> histograms(params.consumers); // Гистограммы потребителей
+    StartGate gate(threadCount); // Стартовые ворота
+    vector<BenchClock::time_point> finished(threadCount); // Время завершения каждого потока
+    vector<thread> threads; // Вектор потоков
+
+    for (int i = 0; i < params.producers; i++) {
+        threads.emplace_back([&, i]() {
+            pinCurrentThread(i); // Закрепление до первого касания памяти
+            vector<char> symbols(params.iterations); // Символы генератора
+            fillRandomSymbols(symbols.data(), symbols.size()); // Пакетная генерация до старта
+            uint64_t sum = 0;
+            for (char symbol : symbols) {
+                sum += static_cast<unsigned char>(symbol);
+            }
+            vector<QueueItem> items(batch); // Пакет для записи
+            gate.arrive(); // Ожидание общего старта
+            for (size_t pos = 0; pos < symbols.size(); pos += batch) {
+                size_t count = min(batch, symbols.size() - pos); // Размер очередного пакета
+                int64_t stamp = nowNs(); // Время постановки пакета
+                for (size_t j = 0; j < count; j++) {
+                    items[j] = {symbols[pos + j], stamp};
+                }
+                int spins = 0; // Шаги ожидания при заполненной очереди
+                for (size_t sent = 0; sent < count;) {
+                    size_t n = queue.enqueue_batch(items.data() + sent, count - sent);
+                    if (n == 0) {
+                        spinOnce(spins); // Очередь заполнена
+                    }
+                    sent += n;
+                }
+            }
+            producedSum.fetch_add(sum, memory_order_relaxed);
+            finished[i] = BenchClock::now(); // Фиксация времени завершения
+        });
+    }
+
+    for (int i = 0; i < params.consumers; i++) {
+        threads.emplace_back([&, i]() {
+            pinCurrentThread(params.producers + i); // Потребители идут после генераторов
+            vector<QueueItem> items(batch); // Пакет для чтения
+            LatencyHistogram& histogram = histograms[i]; // Своя гистограмма
+            uint64_t sum = 0;
+            int spins = 0; // Шаги ожидания при пустой очереди
+            gate.arrive(); // Ожидание общего старта
+            while (consumed.load(memory_order_relaxed) < total) {
+                size_t n = queue.dequeue_batch(items.data(), batch);
+                if (n == 0) {
+                    spinOnce(spins); // Очередь пуста
+                    continue;
+                }
+                spins = 0;
+                int64_t stamp = nowNs(); // Время извлечения
+                for (size_t j = 0; j < n; j++) {
+                    sum += static_cast<unsigned char>(items[j].symbol);
+                    histogram.record(stamp - items[j].enqueuedNs);
+                }
+                consumed.fetch_add(n, memory_order_relaxed);
+            }
+            consumedSum.fetch_add(sum, memory_order_relaxed);
+            finished[params.producers + i] = BenchClock::now(); // Фиксация времени завершения
+        });
+    }
+
+    gate.waitForAll(); // Все потоки созданы и ждут
+    auto start = BenchClock::now(); // Запуск таймера
+    gate.open(); // Старт
+    for (auto& t : threads) {
+        t.join(); // Ожидание завершения потоков
+    }
+    auto end = *max_element(finished.begin(), finished.end()); // Завершение последнего потока
+    for (const auto& histogram : histograms) {
+        latency.merge(histogram);
+    }
+    valid = consumed.load() == total && consumedSum.load() == producedSum.load(); // Ничего не потеряно и не задвоено
+    return chrono::duration<double>(end - start).count(); // Время выполнения
+}
+
+// Функция для создания описания теста очереди заданного класса
+template <typename QueueType>
+PcCase makeQueueCase(const string& name) {
+    return {name, runPcTrial<QueueType>};
+}
+
+// Функция для создания списка тестируемых очередей
+vector<PcCase> makeQueueCases() {
+    return {
+        makeQueueCase<MpmcRing<QueueItem>>("MpmcRing"),
+        makeQueueCase<LockedQueue<QueueItem, mutex>>("MutexQueue"),
+        makeQueueCase<LockedQueue<QueueItem, SemaphoreLock>>("SemaphoreQueue"),
+        makeQueueCase<LockedQueue<QueueItem, SemaphoreSlimLock>>("SemaphoreSlimQueue"),
+        makeQueueCase<LockedQueue<QueueItem, MonitorLock>>("MonitorQueue"),
+        makeQueueCase<LockedQueue<QueueItem, AdaptiveMonitor>>("AdaptiveMonitorQueue"),
+        makeQueueCase<LockedQueue<QueueItem, FlagSpinLock>>("SpinLockQueue"),
+    };
+}
+
+// Функция для выполнения серии прогонов одной очереди
+BenchResult runProducerConsumer(const PcCase& bench, const PcParams& params, const BenchConfig& config) {
+    bool valid = true; // Признак корректности всех прогонов
+    bool trialValid; // Признак корректности одного прогона
+    for (int i = 0; i < config.warmups; i++) {
+        LatencyHistogram discarded; // Задержки прогрева не учитываются
+        bench.run(params, discarded, trialValid);
+        valid = valid && trialValid;
+    }
+    LatencyHistogram latency; // Задержки всех замеряемых прогонов
+    vector<double> samples; // Замеры времени
+    for (int i = 0; i < config.repetitions; i++) {
+        samples.push_back(bench.run(params, latency, trialValid));
+        valid = valid && trialValid;
+    }
+    BenchResult result;
+    result.name = bench.name;
+    result.threadCount = params.producers + params.consumers;
+    result.producers = params.producers;
+    result.consumers = params.consumers;
+    result.iterations = params.iterations;
+    result.repetitions = config.repetitions;
+    result.items = static_cast<size_t>(params.producers) * params.iterations;
+    result.stats = computeStats(samples);
+    result.hasLatency = true;
+    result.latencyP50 = latency.percentile(0.50);
+    result.latencyP90 = latency.percentile(0.90);
+    result.latencyP99 = latency.percentile(0.99);
+    result.valid = valid;
+    return result;
+}
+
+// Функция для получения имени хоста, чтобы сравнивать результаты между машинами
+string hostName() {
+    char buffer[256] = {}; // Буфер для имени
+    if (gethostname(buffer, sizeof(buffer) - 1) != 0) {
+        return "unknown";
+    }
+    return buffer;
+}
+
+// Функция для экранирования строки в JSON
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+// Функция для вывода таблицы инструментирования в текстовом отчёте
+void printContentionTable(const vector<BenchResult>& results) {
+    if (none_of(results.begin(), results.end(), [](const BenchResult& r) { return r.hasContention; })) {
+        return;
+    }
+    cout << "\nContention (per trial; wait/hold in ns; perf n/a when perf_event_open is not permitted)\n";
+    cout << left << setw(20) << "Primitive" << right << setw(8) << "Threads" << setw(11) << "Acq" << setw(9) << "Fair"
+         << setw(11) << "Wait p50" << setw(11) << "Wait p99" << setw(11) << "Hold p50" << setw(11) << "Hold p99"
+         << setw(11) << "Futex" << setw(11) << "Parks" << setw(11) << "Cycles" << setw(11) << "CacheMiss"
+         << setw(11) << "CtxSw" << '\n';
+    for (const auto& r : results) {
+        if (!r.hasContention) {
+            continue;
+        }
+        const ContentionSummary& c = r.contention;
+        cout << left << setw(20) << r.name << right << setw(8) << r.threadCount << setw(11) << c.acquisitionsPerTrial
+             << fixed << setprecision(2) << setw(9) << c.fairness << scientific << setprecision(3)
+             << setw(11) << c.waitP50 << setw(11) << c.waitP99 << setw(11) << c.holdP50 << setw(11) << c.holdP99
+             << setw(11) << c.futexWaitsPerTrial << setw(11) << c.parksPerTrial;
+        for (double value : c.perfPerTrial) {
+            if (value >= 0) {
+                cout << setw(11) << value;
+            }
+            else {
+                cout << setw(11) << "n/a";
+            }
+        }
+        cout << '\n';
+    }
+}
+
+const double COLLAPSE_RATIO = 0.5; // Падение пропускной способности ниже этой доли пика - коллапс
+
+// Функция для вывода сводки масштабирования: пик пропускной способности и точка коллапса
+// для каждого примитива, запущенного с несколькими количествами потоков
+void printScalingSummary(const vector<BenchResult>& results) {
+    vector<string> names; // Имена в порядке появления
+    for (const auto& r : results) {
+        if (find(names.begin(), names.end(), r.name) == names.end()) {
+            names.push_back(r.name);
+        }
+    }
+    bool header = false;
+    for (const auto& name : names) {
+        vector<const BenchResult*> curve; // Кривая масштабирования примитива
+        for (const auto& r : results) {
+            if (r.name == name) {
+                curve.push_back(&r);
+            }
+        }
+        if (curve.size() < 2) {
+            continue;
+        }
+        sort(curve.begin(), curve.end(), [](const BenchResult* a, const BenchResult* b) { return a->threadCount < b->threadCount; });
+        auto opsOf = [](const BenchResult* r) { return r->items / r->stats.median; };
+        const BenchResult* peak = *max_element(curve.begin(), curve.end(),
+                                               [&](const BenchResult* a, const BenchResult* b) { return opsOf(a) < opsOf(b); });
+        const BenchResult* collapse = nullptr; // Первая точка после пика ниже порога
+        for (const BenchResult* r : curve) {
+            if (r->threadCount > peak->threadCount && opsOf(r) < COLLAPSE_RATIO * opsOf(peak)) {
+                collapse = r;
+                break;
+            }
+        }
+        if (!header) {
+            cout << "\nScaling (collapse = first thread count after the peak below " << static_cast<int>(COLLAPSE_RATIO * 100)
+                 << "% of peak throughput)\n";
+            cout << left << setw(20) << "Primitive" << right << setw(12) << "Peak at" << setw(16) << "Peak ops/s"
+                 << setw(14) << "Collapse at" << setw(16) << "Last/peak" << '\n';
+            header = true;
+        }
+        double last = opsOf(curve.back()) / opsOf(peak); // Доля пика при максимальном числе потоков
+        cout << left << setw(20) << name << right << setw(12) << peak->threadCount << setw(16) << opsOf(peak)
+             << setw(14) << (collapse ? to_string(collapse->threadCount) : string("-"))
+             << setw(15) << fixed << setprecision(1) << last * 100 << '%' << scientific << setprecision(3) << '\n';
+    }
+}
+
+// Функция для вывода результатов в выбранном формате
+void printResults(const vector<BenchResult>& results, const string& format) {
+    string host = hostName(); // Имя машины
+    if (format == "csv") {
+        cout << "host,primitive,threads,placement,cpus,producers,consumers,iterations,repetitions,median_s,p90_s,p99_s,stddev_s,"
+                "mean_s,min_s,max_s,items,ops_per_s,latency_p50_ns,latency_p90_ns,latency_p99_ns,"
+                "acquisitions_per_trial,fairness,wait_p50_ns,wait_p99_ns,wait_max_ns,hold_p50_ns,hold_p99_ns,"
+                "futex_waits_per_trial,parks_per_trial,cycles_per_trial,cache_misses_per_trial,context_switches_per_trial,"
+                "valid\n";
+        cout << setprecision(9);
+        for (const auto& r : results) {
+            double ops = r.items / r.stats.median; // Операций в секунду
+            cout << host << ',' << r.name << ',' << r.threadCount << ',' << r.placement << ',' << r.cpus << ',' << r.producers << ',' << r.consumers << ','
+                 << r.iterations << ',' << r.repetitions << ',' << r.stats.median << ',' << r.stats.p90 << ','
+                 << r.stats.p99 << ',' << r.stats.stddev << ',' << r.stats.mean << ',' << r.stats.minimum << ','
+                 << r.stats.maximum << ',' << r.items << ',' << ops << ',';
+            if (r.hasLatency) {
+                cout << r.latencyP50 << ',' << r.latencyP90 << ',' << r.latencyP99;
+            }
+            else {
+                cout << ",,"; // Задержка не измерялась
+            }
+            cout << ',';
+            if (r.hasContention) {
+                const ContentionSummary& c = r.contention;
+                cout << c.acquisitionsPerTrial << ',' << c.fairness << ',' << c.waitP50 << ',' << c.waitP99 << ','
+                     << c.waitMax << ',' << c.holdP50 << ',' << c.holdP99 << ',' << c.futexWaitsPerTrial << ','
+                     << c.parksPerTrial;
+                for (double value : c.perfPerTrial) {
+                    cout << ',';
+                    if (value >= 0) {
+                        cout << value; // Пустое поле - счётчик недоступен
+                    }
+                }
+            }
+            else {
+                cout << ",,,,,,,,,,,"; // Инструментирование не включалось
+            }
+            cout << ',' << (r.valid ? "true" : "false") << '\n';
+        }
+    }
+    else if (format == "json") {
+        cout << setprecision(9) << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& r = results[i];
+            double ops = r.items / r.stats.median; // Операций в секунду
+            cout << "  {\"host\": \"" << jsonEscape(host) << "\", \"primitive\": \"" << jsonEscape(r.name)
+                 << "\", \"threads\": " << r.threadCount << ", \"placement\": \"" << r.placement
+                 << "\", \"cpus\": " << r.cpus << ", \"producers\": " << r.producers
+                 << ", \"consumers\": " << r.consumers << ", \"iterations\": " << r.iterations
+                 << ", \"repetitions\": " << r.repetitions << ", \"median_s\": " << r.stats.median
+                 << ", \"p90_s\": " << r.stats.p90 << ", \"p99_s\": " << r.stats.p99
+                 << ", \"stddev_s\": " << r.stats.stddev << ", \"mean_s\": " << r.stats.mean
+                 << ", \"min_s\": " << r.stats.minimum << ", \"max_s\": " << r.stats.maximum
+                 << ", \"items\": " << r.items << ", \"ops_per_s\": " << ops;
+            if (r.hasLatency) {
+                cout << ", \"latency_p50_ns\": " << r.latencyP50 << ", \"latency_p90_ns\": " << r.latencyP90
+                     << ", \"latency_p99_ns\": " << r.latencyP99;
+            }
+            if (r.hasContention) {
+                const ContentionSummary& c = r.contention;
+                const char* perfNames[] = {"cycles_per_trial", "cache_misses_per_trial", "context_switches_per_trial"};
+                cout << ", \"acquisitions_per_trial\": " << c.acquisitionsPerTrial << ", \"fairness\": " << c.fairness
+                     << ", \"wait_p50_ns\": " << c.waitP50 << ", \"wait_p99_ns\": " << c.waitP99
+                     << ", \"wait_max_ns\": " << c.waitMax << ", \"hold_p50_ns\": " << c.holdP50
+                     << ", \"hold_p99_ns\": " << c.holdP99 << ", \"futex_waits_per_trial\": " << c.futexWaitsPerTrial
+                     << ", \"parks_per_trial\": " << c.parksPerTrial;
+                for (int k = 0; k < PerfCounters::COUNT; k++) {
+                    cout << ", \"" << perfNames[k] << "\": ";
+                    if (c.perfPerTrial[k] >= 0) {
+                        cout << c.perfPerTrial[k];
+                    }
+                    else {
+                        cout << "null"; // Счётчик недоступен
+                    }
+                }
+            }
+            cout << ", \"valid\": " << (r.valid ? "true" : "false") << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        cout << "]\n";
+    }
+    else {
+        bool latency = any_of(results.begin(), results.end(), [](const BenchResult& r) { return r.hasLatency; });
+        cout << left << setw(20) << "Primitive" << right << setw(8) << "Threads" << setw(14) << "Median, s"
+             << setw(14) << "P90, s" << setw(14) << "P99, s" << setw(14) << "Stddev, s" << setw(16) << "Ops/s";
+        if (latency) {
+            cout << setw(14) << "Lat p50, ns" << setw(14) << "Lat p99, ns";
+        }
+        cout << '\n';
+        cout << scientific << setprecision(3);
+        for (const auto& r : results) {
+            double ops = r.items / r.stats.median; // Операций в секунду
+            string threads = r.producers ? to_string(r.producers) + "/" + to_string(r.consumers) : to_string(r.threadCount);
+            cout << left << setw(20) << r.name << right << setw(8) << threads << setw(14) << r.stats.median
+                 << setw(14) << r.stats.p90 << setw(14) << r.stats.p99 << setw(14) << r.stats.stddev
+                 << setw(16) << ops;
+            if (latency) {
+                cout << setw(14) << r.latencyP50 << setw(14) << r.latencyP99;
+            }
+            cout << (r.valid ? "" : "  INVALID") << '\n';
+        }
+        printContentionTable(results);
+        printScalingSummary(results);
+    }
+}
+
+// Функция для создания описания теста барьера заданного класса
+template <typename BarrierType, typename Policy>
+BenchCase makeBarrierCase(const string& name) {
+    return {name, [](int threadCount, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto barrier = make_shared<Instrument<InstrumentedBarrier, BarrierType, Policy>>(threadCount);
+        allSymbols.resize(static_cast<size_t>(threadCount) * iterations);
+        return [barrier, &allSymbols, threadCount, iterations](int index, const char* symbols) {
+            threadBarrier(*barrier, allSymbols, symbols, index, threadCount, iterations);
+        };
+    }};
+}
+
+// Функция для создания описания теста блокировки заданного класса
+template <typename LockType, typename Policy>
+BenchCase makeLockCase(const string& name) {
+    return {name, [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto spinLock = make_shared<Instrument<InstrumentedLock, LockType, Policy>>();
+        return [spinLock, &allSymbols, iterations](int, const char* symbols) {
+            threadLock(*spinLock, allSymbols, symbols, iterations);
+        };
+    }};
+}
+
+// Функция для создания списка тестируемых примитивов; Policy определяет,
+// оборачиваются ли примитивы инструментированием
+template <typename Policy>
+vector<BenchCase> makeBenchCases() {
+    vector<BenchCase> cases;
+
+    // Мьютекс
+    cases.push_back({"Mutex", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto mtx = make_shared<Instrument<InstrumentedLock, mutex, Policy>>();
+        return [mtx, &allSymbols, iterations](int, const char* symbols) { threadMutex(*mtx, allSymbols, symbols, iterations); };
+    }});
+
+    // Семафор; начальное значение 1, так как семафор охраняет общий вектор
+    cases.push_back({"Semaphore", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto sem = make_shared<Instrument<InstrumentedSemaphore, Semaphore, Policy>>(1);
+        return [sem, &allSymbols, iterations](int, const char* symbols) { threadSemaphore(*sem, allSymbols, symbols, iterations); };
+    }});
+
+    // Упрощенный семафор
+    cases.push_back({"SemaphoreSlim", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto semSlim = make_shared<Instrument<InstrumentedSemaphore, SemaphoreSlim, Policy>>(1, 1);
+        return [semSlim, &allSymbols, iterations](int, const char* symbols) { threadSemaphoreSlim(*semSlim, allSymbols, symbols, iterations); };
+    }});
+
+    // Семафор на futex
+    cases.push_back({"FutexSemaphore", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto sem = make_shared<Instrument<InstrumentedSemaphore, FutexSemaphore, Policy>>(1, 1);
+        return [sem, &allSymbols, iterations](int, const char* symbols) { threadSemaphore(*sem, allSymbols, symbols, iterations); };
+    }});
+
+    // Барьеры; вектор заранее размечен по фазам и потокам
+    cases.push_back(makeBarrierCase<Barrier, Policy>("Barrier"));
+    cases.push_back(makeBarrierCase<SenseBarrier, Policy>("SenseBarrier"));
+    cases.push_back(makeBarrierCase<TreeBarrier, Policy>("TreeBarrier"));
+    cases.push_back(makeBarrierCase<DisseminationBarrier, Policy>("DissemBarrier"));
+
+    // Спинлок
+    cases.push_back({"SpinLock", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto spinLock = make_shared<Instrument<InstrumentedFlag, atomic_flag, Policy>>();
+        spinLock->clear();
+        return [spinLock, &allSymbols, iterations](int, const char* symbols) { threadSpinLock(*spinLock, allSymbols, symbols, iterations); };
+    }});
+
+    // Спин-ожидание
+    cases.push_back({"SpinWait", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto spinLock = make_shared<Instrument<InstrumentedFlag, atomic_flag, Policy>>();
+        spinLock->clear();
+        return [spinLock, &allSymbols, iterations](int, const char* symbols) { threadSpinWait(*spinLock, allSymbols, symbols, iterations); };
+    }});
+
+    // Спинлоки с очередями и задержкой
+    cases.push_back(makeLockCase<TTASLock, Policy>("TTASLock"));
+    cases.push_back(makeLockCase<TicketLock, Policy>("TicketLock"));
+    cases.push_back(makeLockCase<MCSLock, Policy>("MCSLock"));
+    cases.push_back(makeLockCase<CLHLock, Policy>("CLHLock"));
+
+    // Запись без блокировок: сегменты потоков; последний завершившийся поток
+    // сливает сегменты в общий вектор, так что слияние входит в замер
+    cases.push_back({"ShardedBuffer", [](int threadCount, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto buffer = make_shared<ShardedAppendBuffer>(threadCount, iterations);
+        auto running = make_shared<atomic<int>>(threadCount);
+        return [buffer, running, &allSymbols, iterations](int index, const char* symbols) {
+            threadSharded(*buffer, index, symbols, iterations);
+            if (running->fetch_sub(1, memory_order_acq_rel) == 1) {
+                buffer->mergeInto(allSymbols); // Слияние за O(1) на символ
+            }
+        };
+    }});
+
+    // Запись без блокировок: пакеты в заранее выделенный общий вектор
+    cases.push_back({"BumpBuffer", [](int threadCount, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        allSymbols.resize(static_cast<size_t>(threadCount) * iterations);
+        auto buffer = make_shared<BumpAppendBuffer>(allSymbols.data(), allSymbols.size());
+        return [buffer, iterations](int, const char* symbols) { threadBump(*buffer, symbols, iterations); };
+    }});
+
+    // Монитор
+    cases.push_back({"Monitor", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto monitor = make_shared<Instrument<InstrumentedMonitor, Monitor, Policy>>();
+        return [monitor, &allSymbols, iterations](int, const char* symbols) { threadMonitor(*monitor, allSymbols, symbols, iterations); };
+    }});
+
+    // Адаптивный монитор: перехват ради пропускной способности и прямая передача по очереди
+    cases.push_back({"AdaptiveMonitor", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto monitor = make_shared<Instrument<InstrumentedMonitor, AdaptiveMonitor, Policy>>(AdaptiveMonitor::Mode::Throughput);
+        return [monitor, &allSymbols, iterations](int, const char* symbols) { threadMonitor(*monitor, allSymbols, symbols, iterations); };
+    }});
+    cases.push_back({"AdaptiveMonitorFifo", [](int, int iterations, vector<char>& allSymbols) -> ThreadBody {
+        auto monitor = make_shared<Instrument<InstrumentedMonitor, AdaptiveMonitor, Policy>>(AdaptiveMonitor::Mode::Fifo);
+        return [monitor, &allSymbols, iterations](int, const char* symbols) { threadMonitor(*monitor, allSymbols, symbols, iterations); };
+    }});
+
+    return cases;
+}
+
+// Функция для разбора списка значений через запятую
+vector<string> splitList(const string& value) {
+    vector<string> items;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Функция для разбора положительного целого аргумента
+bool parsePositive(const string& value, int& out, bool allowZero = false) {
+    char* endPtr = nullptr;
+    long parsed = strtol(value.c_str(), &endPtr, 10);
+    if (value.empty() || *endPtr != '\0' || parsed < (allowZero ? 0 : 1) || parsed > 1000000000) {
+        return false;
+    }
+    out = static_cast<int>(parsed);
+    return true;
+}
+
+// Функция для вывода справки
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [options]\n"
+         << "  --threads=LIST       thread counts to run, e.g. 1,2,4,8 (default 4)\n"
+         << "  --iterations=N       iterations per thread (default " << N << ")\n"
+         << "  --repetitions=N      measured runs per primitive (default 10)\n"
+         << "  --warmup=N           discarded warm-up runs (default 2)\n"
+         << "  --format=FMT         text, csv or json (default text)\n"
+         << "  --only=LIST          run only the named primitives, e.g. Mutex,SpinLock\n"
+         << "  --rng=KIND           symbol generator: xoshiro, pcg or mt (default xoshiro)\n"
+         << "  --seed=N             generator seed for reproducible symbols (default random)\n"
+         << "  --mode=MODE          locks (threads share one vector) or pc (producer/consumer queues)\n"
+         << "  --producers=N        generator threads in pc mode (default 2)\n"
+         << "  --consumers=N        consumer threads in pc mode (default 2)\n"
+         << "  --batch=N            items per enqueue/dequeue in pc mode (default 1)\n"
+         << "  --capacity=N         queue capacity in pc mode, power of two (default 1024)\n"
+         << "  --instrument         collect wait/hold histograms, park counts and perf counters (locks mode)\n"
+         << "  --placement=POLICY   pin threads: none, compact (SMT siblings first), spread (one per core),\n"
+         << "                       sockets (round-robin over NUMA nodes) (default none)\n"
+         << "  --sweep              run thread counts from 1 to 4x the CPU count and report collapse points\n"
+         << "  --topology           print the detected CPU topology and exit\n"
+         << "  --help               show this help\n";
+}
+
+// Функция для разбора аргументов командной строки; возвращает false при ошибке
+bool parseArguments(int argc, char* argv[], BenchConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('='); // Разделитель имени и значения
+        string key = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--threads") {
+            config.threadCounts.clear();
+            for (const auto& item : splitList(value)) {
+                int count;
+                if (!parsePositive(item, count)) {
+                    cerr << "Invalid thread count: " << item << '\n';
+                    return false;
+                }
+                config.threadCounts.push_back(count);
+            }
+            if (config.threadCounts.empty()) {
+                cerr << "Empty thread count list\n";
+                return false;
+            }
+        }
+        else if (key == "--iterations" || key == "--repetitions" || key == "--warmup" || key == "--producers"
+                 || key == "--consumers" || key == "--batch" || key == "--capacity") {
+            int* target = key == "--iterations" ? &config.iterations
+                        : key == "--repetitions" ? &config.repetitions
+                        : key == "--producers" ? &config.producers
+                        : key == "--consumers" ? &config.consumers
+                        : key == "--batch" ? &config.batch
+                        : key == "--capacity" ? &config.capacity : &config.warmups;
+            if (!parsePositive(value, *target, key == "--warmup")) {
+                cerr << "Invalid value for " << key << ": " << value << '\n';
+                return false;
+            }
+        }
+        else if (key == "--format") {
+            if (value != "text" && value != "csv" && value != "json") {
+                cerr << "Unknown format: " << value << '\n';
+                return false;
+            }
+            config.format = value;
+        }
+        else if (key == "--instrument") {
+            config.instrument = true;
+        }
+        else if (key == "--sweep") {
+            config.sweep = true;
+        }
+        else if (key == "--topology") {
+            config.showTopology = true;
+        }
+        else if (key == "--placement") {
+            if (value == "none") {
+                config.placement = Placement::None;
+            }
+            else if (value == "compact") {
+                config.placement = Placement::Compact;
+            }
+            else if (value == "spread") {
+                config.placement = Placement::Spread;
+            }
+            else if (value == "sockets") {
+                config.placement = Placement::Sockets;
+            }
+            else {
+                cerr << "Unknown placement: " << value << '\n';
+                return false;
+            }
+        }
+        else if (key == "--mode") {
+            if (value != "locks" && value != "pc") {
+                cerr << "Unknown mode: " << value << '\n';
+                return false;
+            }
+            config.mode = value;
+        }
+        else if (key == "--only") {
+            config.only = splitList(value);
+        }
+        else if (key == "--rng") {
+            if (value == "xoshiro") {
+                config.rng = RngKind::Xoshiro;
+            }
+            else if (value == "pcg") {
+                config.rng = RngKind::Pcg;
+            }
+            else if (value == "mt") {
+                config.rng = RngKind::Mt;
+            }
+            else {
+                cerr << "Unknown generator: " << value << '\n';
+                return false;
+            }
+        }
+        else if (key == "--seed") {
+            char* endPtr = nullptr;
+            config.seed = strtoull(value.c_str(), &endPtr, 10);
+            if (value.empty() || *endPtr != '\0') {
+                cerr << "Invalid seed: " << value << '\n';
+                return false;
+            }
+        }
+        else {
+            cerr << "Unknown option: " << arg << '\n';
+            return false;
+        }
+    }
+    if (config.capacity < 2 || (config.capacity & (config.capacity - 1)) != 0) {
+        cerr << "Queue capacity must be a power of two: " << config.capacity << '\n';
+        return false;
+    }
+    return true;
+}
+
+// Функция для проверки, выбран ли примитив фильтром --only
+bool isSelected(const string& name, const vector<string>& only) {
+    return only.empty() || find(only.begin(), only.end(), name) != only.end();
+}
+
+// Функция для проверки, что все имена из фильтра --only существуют
+template <typename Case>
+bool checkNames(const vector<Case>& cases, const vector<string>& only) {
+    for (const auto& name : only) {
+        bool known = any_of(cases.begin(), cases.end(), [&](const Case& c) { return c.name == name; });
+        if (!known) {
+            cerr << "Unknown primitive: " << name << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+// Основная функция
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--help") {
+            printUsage(argv[0]); // Вывод справки
+            return 0;
+        }
+    }
+
+    BenchConfig config; // Параметры запуска
+    if (!parseArguments(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    symbolRngKind = config.rng; // Выбор генератора символов
+    symbolSeed = config.seed; // Зерно генератора
+
+    vector<CpuInfo> topology = readCpuTopology(); // Доступные процессоры
+    if (config.showTopology) {
+        printTopology(topology);
+        return 0;
+    }
+    int cpuCount = topology.empty() ? max(1u, thread::hardware_concurrency()) : static_cast<int>(topology.size());
+    placementCpus = placementOrder(topology, config.placement); // Порядок закрепления потоков
+    if (config.sweep) {
+        config.threadCounts = sweepThreadCounts(cpuCount);
+    }
+    const char* placementNames[] = {"none", "compact", "spread", "sockets"};
+
+    vector<BenchResult> results; // Результаты всех серий
+    if (config.mode == "pc") {
+        vector<PcCase> cases = makeQueueCases(); // Список очередей
+        if (!checkNames(cases, config.only)) {
+            return 1;
+        }
+        PcParams params{config.producers, config.consumers, config.iterations, config.batch,
+                        static_cast<size_t>(config.capacity)};
+        for (const auto& bench : cases) {
+            if (isSelected(bench.name, config.only)) {
+                results.push_back(runProducerConsumer(bench, params, config)); // Серия прогонов
+            }
+        }
+    }
+    else {
+        vector<BenchCase> cases = config.instrument ? makeBenchCases<ContentionInstrumentation>()
+                                                    : makeBenchCases<NoInstrumentation>(); // Список примитивов
+        if (!checkNames(cases, config.only)) {
+            return 1;
+        }
+        for (int threadCount : config.threadCounts) {
+            for (const auto& bench : cases) {
+                if (isSelected(bench.name, config.only)) {
+                    results.push_back(runBenchmark(bench, threadCount, config)); // Серия прогонов
+                }
+            }
+        }
+    }
+
+    for (auto& r : results) {
+        r.placement = placementNames[static_cast<int>(config.placement)];
+        r.cpus = cpuCount;
+    }
+
+    printResults(results, config.format); // Вывод отчёта
 
-    return 0; // Завершение программы
+    bool allValid = all_of(results.begin(), results.end(), [](const BenchResult& r) { return r.valid; });
+    return allValid ? 0 : 2; // Завершение программы
 }
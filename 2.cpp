@@ -6,6 +6,33 @@
 #include <ctime>       // Для работы с временем
 #include <sstream>     // Для работы со строками
 #include <random>      // Для генерации случайных чисел
+#include <cstdint>     // Для целочисленных типов фиксированной ширины
+#include <cstdio>      // Для snprintf
+#include <unordered_map> // Для словаря тренеров
+#include <stdexcept>   // Для исключений
+#include <climits>     // Для границ целых типов
+#include <algorithm>   // Для fill и equal
+#include <atomic>      // Для атомарных счетчиков
+#include <condition_variable> // Для ожидания работы в пуле
+#include <deque>       // Для очередей задач пула
+#include <functional>  // Для function
+#include <future>      // Для результатов задач пула
+#include <memory>      // Для unique_ptr и shared_ptr
+#include <mutex>       // Для защиты очередей пула
+#include <new>         // Для выровненного operator new
+#include <fstream>     // Для чтения CSV и записи файлов набора данных
+#include <string_view> // Для полей CSV без копирования
+#include <cstring>     // Для memchr и strerror
+#include <cerrno>      // Для errno
+#include <fcntl.h>     // Для open
+#include <sys/mman.h>  // Для mmap
+#include <sys/stat.h>  // Для fstat
+#include <sys/uio.h>   // Для writev
+#include <unistd.h>    // Для close
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // Для векторных инструкций AVX2/AVX-512
+#define TRAINING_SIMD_X86 1
+#endif
 
 using namespace std;
 
@@ -16,75 +43,2380 @@ struct Training {
     string coachName;  // ФИО тренера
 };
 
+// Признак некорректной даты в колонке дней
+constexpr int32_t INVALID_DAY = INT32_MIN;
+
+// Високосный ли год
+constexpr bool isLeapYear(int year) {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+// Количество дней в месяце
+constexpr unsigned daysInMonth(int year, unsigned month) {
+    constexpr unsigned lengths[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : lengths[month - 1];
+}
+
+// Количество дней от 1970-01-01 для даты григорианского календаря
+constexpr int32_t daysFromCivil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+// Обратное преобразование: дни от эпохи -> год, месяц, день
+constexpr void civilFromDays(int32_t days, int& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+}
+
+// День недели по номеру дня от эпохи (0 - воскресенье; 1970-01-01 был четвергом)
+constexpr int weekdayFromDays(int32_t days) {
+    return days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6;
+}
+
+// Разбор числа из не более чем maxDigits цифр
+constexpr bool parseNumber(const char*& p, const char* end, int maxDigits, unsigned& value) {
+    value = 0;
+    int digits = 0;
+    while (p != end && *p >= '0' && *p <= '9' && digits < maxDigits) {
+        value = value * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+        ++digits;
+    }
+    return digits > 0;
+}
+
+// Разбор даты "YYYY-M-D" или "YYYY-MM-DD" без выделения памяти и локали
+constexpr bool parseDate(const char* text, size_t length, int32_t& days) {
+    const char* p = text;
+    const char* end = text + length;
+    unsigned year = 0, month = 0, day = 0;
+    if (!parseNumber(p, end, 4, year) || p == end || *p++ != '-' ||
+        !parseNumber(p, end, 2, month) || p == end || *p++ != '-' ||
+        !parseNumber(p, end, 2, day) || p != end) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(static_cast<int>(year), month)) {
+        return false;
+    }
+    days = daysFromCivil(static_cast<int>(year), month, day);
+    return true;
+}
+
+// Границы дней, которые может дать parseDate (годы 0..9999)
+constexpr int32_t FIRST_DAY = daysFromCivil(0, 1, 1);
+constexpr int32_t LAST_DAY = daysFromCivil(9999, 12, 31);
+
+// Минут в сутках: время записи всегда меньше
+constexpr uint16_t MINUTES_PER_DAY = 24 * 60;
+
+// Разбор времени "H:MM" или "HH:MM" в минуты от полуночи
+constexpr bool parseTime(const char* text, size_t length, uint16_t& minutes) {
+    const char* p = text;
+    const char* end = text + length;
+    unsigned hour = 0, minute = 0;
+    if (!parseNumber(p, end, 2, hour) || p == end || *p++ != ':' ||
+        !parseNumber(p, end, 2, minute) || p != end || hour > 23 || minute > 59) {
+        return false;
+    }
+    minutes = static_cast<uint16_t>(hour * 60 + minute);
+    return true;
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "эпоха");
+static_assert(weekdayFromDays(daysFromCivil(2024, 1, 1)) == 1, "2024-01-01 - понедельник");
+static_assert(weekdayFromDays(daysFromCivil(1969, 12, 28)) == 0, "1969-12-28 - воскресенье");
+static_assert([] { int32_t d = 0; return parseDate("2024-2-29", 9, d) && d == daysFromCivil(2024, 2, 29); }(),
+              "разбор даты без ведущих нулей");
+static_assert([] { int32_t d = 0; return !parseDate("2023-02-29", 10, d); }(), "29 февраля невисокосного года");
+
+// Пакетный разбор: массив строк дат -> массив дней; возвращает число некорректных дат
+size_t parseDates(const string* dates, size_t count, int32_t* days) {
+    size_t invalid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!parseDate(dates[i].data(), dates[i].size(), days[i])) {
+            days[i] = INVALID_DAY;
+            ++invalid;
+        }
+    }
+    return invalid;
+}
+
+// То же для дат внутри записей о тренировках
+size_t parseDates(const Training* trainings, size_t count, int32_t* days) {
+    size_t invalid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!parseDate(trainings[i].date.data(), trainings[i].date.size(), days[i])) {
+            days[i] = INVALID_DAY;
+            ++invalid;
+        }
+    }
+    return invalid;
+}
+
+// Форматирование даты "YYYY-M-D" в буфер без временных строк; возвращает длину
+size_t formatDate(int32_t days, char* out) {
+    int year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    return static_cast<size_t>(snprintf(out, 16, "%d-%u-%u", year, month, day));
+}
+
+// Форматирование времени "H:MM" из минут от полуночи; возвращает длину
+size_t formatTime(uint16_t minutes, char* out) {
+    unsigned hour = minutes / 60u, minute = minutes % 60u;
+    size_t length = 0;
+    if (hour >= 10) {
+        out[length++] = static_cast<char>('0' + hour / 10);
+    }
+    out[length++] = static_cast<char>('0' + hour % 10);
+    out[length++] = ':';
+    out[length++] = static_cast<char>('0' + minute / 10);
+    out[length++] = static_cast<char>('0' + minute % 10);
+    return length;
+}
+
+// Словарь тренеров: ФИО хранится один раз, в записях - только номер
+struct CoachDictionary {
+    vector<string> names;
+    unordered_map<string, uint16_t> ids;
+
+    uint16_t intern(const string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        if (names.size() > UINT16_MAX) {
+            throw runtime_error("слишком много тренеров для 16-битного идентификатора");
+        }
+        uint16_t id = static_cast<uint16_t>(names.size());
+        names.push_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
+
+    // Номер проверяется: колонка тренеров может прийти из поврежденного файла
+    const string& name(uint16_t id) const {
+        if (id >= names.size()) {
+            throw runtime_error("номер тренера " + to_string(id) + " вне словаря");
+        }
+        return names[id];
+    }
+};
+
+// Представление колонок только для чтения - по нему работают проходы фильтрации
+struct TrainingView {
+    const int32_t* days = nullptr;     // Дата: дни от 1970-01-01
+    const uint16_t* minutes = nullptr; // Время: минуты от полуночи
+    const uint16_t* coaches = nullptr; // Номер тренера в словаре
+    size_t size = 0;
+
+    // Подмножество строк [begin, begin + count)
+    TrainingView slice(size_t begin, size_t count) const {
+        return {days + begin, minutes + begin, coaches + begin, count};
+    }
+};
+
+// Колоночное хранилище тренировок (структура массивов вместо массива структур)
+struct TrainingColumns {
+    vector<int32_t> days;
+    vector<uint16_t> minutes;
+    vector<uint16_t> coaches;
+    CoachDictionary dictionary;
+
+    size_t size() const {
+        return days.size();
+    }
+
+    void reserve(size_t count) {
+        days.reserve(count);
+        minutes.reserve(count);
+        coaches.reserve(count);
+    }
+
+    void append(int32_t day, uint16_t minute, uint16_t coach) {
+        days.push_back(day);
+        minutes.push_back(minute);
+        coaches.push_back(coach);
+    }
+
+    TrainingView view() const {
+        return {days.data(), minutes.data(), coaches.data(), days.size()};
+    }
+};
+
+// Преобразование массива записей в колоночный вид
+TrainingColumns toColumns(const vector<Training>& trainings) {
+    TrainingColumns columns;
+    columns.days.resize(trainings.size());
+    if (parseDates(trainings.data(), trainings.size(), columns.days.data()) != 0) {
+        throw invalid_argument("некорректная дата во входных данных");
+    }
+    columns.minutes.resize(trainings.size());
+    columns.coaches.resize(trainings.size());
+    for (size_t i = 0; i < trainings.size(); ++i) {
+        const string& time = trainings[i].time;
+        if (!parseTime(time.data(), time.size(), columns.minutes[i])) {
+            throw invalid_argument("некорректное время: " + time);
+        }
+        columns.coaches[i] = columns.dictionary.intern(trainings[i].coachName);
+    }
+    return columns;
+}
+
+// Восстановление записи из колонок (в том же формате, что выдает генератор)
+Training toTraining(const TrainingView& view, const CoachDictionary& dictionary, size_t row) {
+    char date[16];
+    formatDate(view.days[row], date);
+    char time[8];
+    time[formatTime(view.minutes[row], time)] = '\0';
+    return {date, time, dictionary.name(view.coaches[row])};
+}
+
+Training toTraining(const TrainingColumns& columns, size_t row) {
+    return toTraining(columns.view(), columns.dictionary, row);
+}
+
+// Восстановление выбранных строк
+vector<Training> toTrainings(const TrainingView& view, const CoachDictionary& dictionary, const vector<uint32_t>& rows) {
+    vector<Training> trainings;
+    trainings.reserve(rows.size());
+    for (uint32_t row : rows) {
+        trainings.push_back(toTraining(view, dictionary, row));
+    }
+    return trainings;
+}
+
+vector<Training> toTrainings(const TrainingColumns& columns, const vector<uint32_t>& rows) {
+    return toTrainings(columns.view(), columns.dictionary, rows);
+}
+
+// Составной запрос: незаданные условия (значения по умолчанию) не проверяются
+struct TrainingQuery {
+    int dayOfWeek = -1;              // День недели 0..6 или -1
+    int32_t fromDay = INT32_MIN;     // Диапазон дат, включительно
+    int32_t toDay = INT32_MAX;
+    int coach = -1;                  // Номер тренера или -1
+    uint16_t fromMinute = 0;         // Окно времени [fromMinute, toMinute)
+    uint16_t toMinute = 24 * 60;
+
+    bool hasWeekday() const { return dayOfWeek >= 0; }
+    bool hasDayRange() const { return fromDay != INT32_MIN || toDay != INT32_MAX; }
+    bool hasCoach() const { return coach >= 0; }
+    bool hasMinuteWindow() const { return fromMinute != 0 || toMinute < 24 * 60; }
+};
+
+// Построчная проверка запроса (эталон и обработка хвоста)
+bool matchesQuery(const TrainingView& view, size_t row, const TrainingQuery& query) {
+    return (!query.hasWeekday() || weekdayFromDays(view.days[row]) == query.dayOfWeek) &&
+           (view.days[row] >= query.fromDay && view.days[row] <= query.toDay) &&
+           (!query.hasCoach() || view.coaches[row] == query.coach) &&
+           (view.minutes[row] >= query.fromMinute && view.minutes[row] < query.toMinute);
+}
+
+// Ядра фильтра: обрабатывают words * 64 строк и сужают битовую маску выборки (бит = строка).
+// Слова, уже равные нулю, пропускаются - последующие условия дешевле первого.
+struct FilterKernels {
+    const char* name;
+    void (*weekday)(const int32_t* days, size_t words, int dayOfWeek, uint64_t* bits);
+    void (*dayRange)(const int32_t* days, size_t words, int32_t fromDay, int32_t toDay, uint64_t* bits);
+    void (*coach)(const uint16_t* coaches, size_t words, uint16_t coach, uint64_t* bits);
+    void (*minuteWindow)(const uint16_t* minutes, size_t words, uint16_t fromMinute, uint16_t toMinute, uint64_t* bits);
+};
+
+void weekdayScalar(const int32_t* days, size_t words, int dayOfWeek, uint64_t* bits) {
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; ++j) {
+            mask |= static_cast<uint64_t>(weekdayFromDays(days[w * 64 + j]) == dayOfWeek) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+void dayRangeScalar(const int32_t* days, size_t words, int32_t fromDay, int32_t toDay, uint64_t* bits) {
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; ++j) {
+            int32_t d = days[w * 64 + j];
+            mask |= static_cast<uint64_t>(d >= fromDay && d <= toDay) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+void coachScalar(const uint16_t* coaches, size_t words, uint16_t coach, uint64_t* bits) {
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; ++j) {
+            mask |= static_cast<uint64_t>(coaches[w * 64 + j] == coach) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+void minuteWindowScalar(const uint16_t* minutes, size_t words, uint16_t fromMinute, uint16_t toMinute, uint64_t* bits) {
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; ++j) {
+            uint16_t m = minutes[w * 64 + j];
+            mask |= static_cast<uint64_t>(m >= fromMinute && m < toMinute) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+#ifdef TRAINING_SIMD_X86
+// День недели в double: r = x - 7 * floor((x + 0.5) / 7), x = days + 4.
+// Для любого int32 частное отстоит от целого минимум на 0.5/7, поэтому округление точно.
+__attribute__((target("avx2")))
+void weekdayAvx2(const int32_t* days, size_t words, int dayOfWeek, uint64_t* bits) {
+    const __m256d four = _mm256_set1_pd(4.0), half = _mm256_set1_pd(0.5);
+    const __m256d seven = _mm256_set1_pd(7.0), inv7 = _mm256_set1_pd(1.0 / 7.0);
+    const __m256d target = _mm256_set1_pd(dayOfWeek);
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 4) {
+            __m256d x = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(days + w * 64 + j))), four);
+            __m256d q = _mm256_floor_pd(_mm256_mul_pd(_mm256_add_pd(x, half), inv7));
+            __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(q, seven));
+            mask |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(r, target, _CMP_EQ_OQ))) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+__attribute__((target("avx2")))
+void dayRangeAvx2(const int32_t* days, size_t words, int32_t fromDay, int32_t toDay, uint64_t* bits) {
+    const __m256i from = _mm256_set1_epi32(fromDay), to = _mm256_set1_epi32(toDay);
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 8) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(days + w * 64 + j));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(from, d), _mm256_cmpgt_epi32(d, to));
+            mask |= static_cast<uint64_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+// 16 масок по 16 бит -> 16 бит выборки
+__attribute__((target("avx2")))
+inline uint64_t movemask16Avx2(__m256i m) {
+    __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    return static_cast<uint16_t>(_mm_movemask_epi8(packed));
+}
+
+__attribute__((target("avx2")))
+void coachAvx2(const uint16_t* coaches, size_t words, uint16_t coach, uint64_t* bits) {
+    const __m256i target = _mm256_set1_epi16(static_cast<short>(coach));
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 16) {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coaches + w * 64 + j));
+            mask |= movemask16Avx2(_mm256_cmpeq_epi16(c, target)) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+// m - from < to - from в беззнаковой арифметике, через min: t <= span - 1
+__attribute__((target("avx2")))
+void minuteWindowAvx2(const uint16_t* minutes, size_t words, uint16_t fromMinute, uint16_t toMinute, uint64_t* bits) {
+    if (toMinute <= fromMinute) {
+        fill(bits, bits + words, 0);
+        return;
+    }
+    const __m256i from = _mm256_set1_epi16(static_cast<short>(fromMinute));
+    const __m256i last = _mm256_set1_epi16(static_cast<short>(toMinute - fromMinute - 1));
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 16) {
+            __m256i t = _mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(minutes + w * 64 + j)), from);
+            mask |= movemask16Avx2(_mm256_cmpeq_epi16(_mm256_min_epu16(t, last), t)) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void weekdayAvx512(const int32_t* days, size_t words, int dayOfWeek, uint64_t* bits) {
+    const __m512d four = _mm512_set1_pd(4.0), half = _mm512_set1_pd(0.5);
+    const __m512d seven = _mm512_set1_pd(7.0), inv7 = _mm512_set1_pd(1.0 / 7.0);
+    const __m512d target = _mm512_set1_pd(dayOfWeek);
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 8) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(days + w * 64 + j));
+            __m512d x = _mm512_add_pd(_mm512_maskz_cvtepi32_pd(0xFF, d), four);
+            __m512d q = _mm512_maskz_roundscale_pd(0xFF, _mm512_mul_pd(_mm512_add_pd(x, half), inv7),
+                                                   _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+            __m512d r = _mm512_fnmadd_pd(q, seven, x);
+            mask |= static_cast<uint64_t>(_mm512_cmp_pd_mask(r, target, _CMP_EQ_OQ)) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void dayRangeAvx512(const int32_t* days, size_t words, int32_t fromDay, int32_t toDay, uint64_t* bits) {
+    const __m512i from = _mm512_set1_epi32(fromDay), to = _mm512_set1_epi32(toDay);
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 16) {
+            __m512i d = _mm512_loadu_si512(days + w * 64 + j);
+            mask |= static_cast<uint64_t>(_mm512_mask_cmple_epi32_mask(_mm512_cmpge_epi32_mask(d, from), d, to)) << j;
+        }
+        bits[w] &= mask;
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void coachAvx512(const uint16_t* coaches, size_t words, uint16_t coach, uint64_t* bits) {
+    const __m512i target = _mm512_set1_epi16(static_cast<short>(coach));
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        uint64_t lo = _mm512_cmpeq_epi16_mask(_mm512_loadu_si512(coaches + w * 64), target);
+        uint64_t hi = _mm512_cmpeq_epi16_mask(_mm512_loadu_si512(coaches + w * 64 + 32), target);
+        bits[w] &= lo | hi << 32;
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void minuteWindowAvx512(const uint16_t* minutes, size_t words, uint16_t fromMinute, uint16_t toMinute, uint64_t* bits) {
+    if (toMinute <= fromMinute) {
+        fill(bits, bits + words, 0);
+        return;
+    }
+    const __m512i from = _mm512_set1_epi16(static_cast<short>(fromMinute));
+    const __m512i span = _mm512_set1_epi16(static_cast<short>(toMinute - fromMinute));
+    for (size_t w = 0; w < words; ++w) {
+        if (bits[w] == 0) continue;
+        __m512i lo = _mm512_sub_epi16(_mm512_loadu_si512(minutes + w * 64), from);
+        __m512i hi = _mm512_sub_epi16(_mm512_loadu_si512(minutes + w * 64 + 32), from);
+        bits[w] &= static_cast<uint64_t>(_mm512_cmplt_epu16_mask(lo, span)) |
+                   static_cast<uint64_t>(_mm512_cmplt_epu16_mask(hi, span)) << 32;
+    }
+}
+#endif
+
+// Уровни векторных инструкций
+enum class SimdLevel { Scalar, Avx2, Avx512 };
+
+// Лучший уровень, поддерживаемый процессором
+SimdLevel detectSimdLevel() {
+#ifdef TRAINING_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return SimdLevel::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::Avx2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+// Набор ядер для уровня (не выше поддерживаемого процессором)
+const FilterKernels& filterKernels(SimdLevel level) {
+    static const FilterKernels scalar = {"scalar", weekdayScalar, dayRangeScalar, coachScalar, minuteWindowScalar};
+#ifdef TRAINING_SIMD_X86
+    static const FilterKernels avx2 = {"avx2", weekdayAvx2, dayRangeAvx2, coachAvx2, minuteWindowAvx2};
+    static const FilterKernels avx512 = {"avx512", weekdayAvx512, dayRangeAvx512, coachAvx512, minuteWindowAvx512};
+    static const SimdLevel supported = detectSimdLevel();
+    if (level > supported) {
+        level = supported;
+    }
+    if (level == SimdLevel::Avx512) return avx512;
+    if (level == SimdLevel::Avx2) return avx2;
+#endif
+    (void)level;
+    return scalar;
+}
+
+// Битовая маска выборки по запросу: полные слова - ядрами, хвост - построчно
+void selectRows(const TrainingView& view, const TrainingQuery& query, vector<uint64_t>& bitmap, const FilterKernels& kernels) {
+    const size_t fullWords = view.size / 64;
+    const size_t tail = view.size % 64;
+    bitmap.assign(fullWords + (tail ? 1 : 0), ~0ull);
+    if (query.hasWeekday()) kernels.weekday(view.days, fullWords, query.dayOfWeek, bitmap.data());
+    if (query.hasDayRange()) kernels.dayRange(view.days, fullWords, query.fromDay, query.toDay, bitmap.data());
+    if (query.hasCoach()) kernels.coach(view.coaches, fullWords, static_cast<uint16_t>(query.coach), bitmap.data());
+    if (query.hasMinuteWindow()) kernels.minuteWindow(view.minutes, fullWords, query.fromMinute, query.toMinute, bitmap.data());
+    if (tail) {
+        uint64_t mask = 0;
+        for (size_t j = 0; j < tail; ++j) {
+            mask |= static_cast<uint64_t>(matchesQuery(view, fullWords * 64 + j, query)) << j;
+        }
+        bitmap[fullWords] = mask;
+    }
+}
+
+// Сжатие маски в номера строк (firstRow - номер строки первого бита)
+void compactSelection(const uint64_t* bits, size_t words, uint32_t firstRow, vector<uint32_t>& rows) {
+    size_t count = 0;
+    for (size_t w = 0; w < words; ++w) {
+        count += static_cast<size_t>(__builtin_popcountll(bits[w]));
+    }
+    rows.resize(count);
+    uint32_t* out = rows.data();
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            *out++ = firstRow + static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+        }
+    }
+}
+
+// Выборка по запросу: маска + сжатие в номера строк
+void filterRows(const TrainingView& view, const TrainingQuery& query, vector<uint32_t>& rows,
+                const FilterKernels& kernels = filterKernels(SimdLevel::Avx512)) {
+    vector<uint64_t> bitmap;
+    selectRows(view, query, bitmap, kernels);
+    compactSelection(bitmap.data(), bitmap.size(), 0, rows);
+}
+
 // Функция для проверки, является ли дата тренировок днем недели D
 bool isTrainingOnDay(const Training& training, int dayOfWeek) {
+    int32_t days = 0;
+    return parseDate(training.date.data(), training.date.size(), days) && weekdayFromDays(days) == dayOfWeek;
+}
+
+// Прежний способ через get_time (оставлен для сравнения скорости);
+// get_time не заполняет tm_wday, поэтому день недели досчитывает mktime
+bool isTrainingOnDayGetTime(const Training& training, int dayOfWeek) {
     tm tm = {};
     stringstream ss(training.date);
     ss >> get_time(&tm, "%Y-%m-%d");
+    tm.tm_hour = 12;
+    mktime(&tm);
     return (tm.tm_wday == dayOfWeek);
 }
 
-// Функция обработки данных с использованием многопоточности
-void processWithThreads(const vector<Training>& trainings, int dayOfWeek, vector<Training>& results, size_t start, size_t end) {
-    for (size_t i = start; i < end; ++i) {
-        if (isTrainingOnDay(trainings[i], dayOfWeek)) {
-            results.push_back(trainings[i]);
+// Совпадают ли два списка тренировок поэлементно
+bool sameTrainings(const vector<Training>& a, const vector<Training>& b) {
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), [](const Training& x, const Training& y) {
+        return x.date == y.date && x.time == y.time && x.coachName == y.coachName;
+    });
+}
+
+// Исключающая префиксная сумма: counts[i] -> смещение i-го блока; возвращает общий размер
+size_t exclusivePrefixSum(vector<size_t>& counts) {
+    size_t total = 0;
+    for (auto& count : counts) {
+        size_t value = count;
+        count = total;
+        total += value;
+    }
+    return total;
+}
+
+// Пул потоков с кражей работы: у каждого потока своя очередь задач. Свои задачи
+// поток берет с конца (последние - горячие в кэше), чужие крадет с начала (там
+// самые крупные куски рекурсивного деления).
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) {
+        threads = max(threads, 1);
+        for (int i = 0; i < threads; ++i) {
+            queues.emplace_back(new WorkerQueue);
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const {
+        return static_cast<int>(workers.size());
+    }
+
+    // Выполняется ли текущий поток как рабочий какого-либо пула
+    static bool insidePool() {
+        return currentPool != nullptr;
+    }
+
+    // Отдельная задача с результатом через future
+    template <typename F>
+    auto submit(F&& f) -> future<decltype(f())> {
+        auto task = make_shared<packaged_task<decltype(f())()>>(forward<F>(f));
+        auto result = task->get_future();
+        push([task] { (*task)(); });
+        return result;
+    }
+
+    // Параллельный цикл по [begin, end): диапазон рекурсивно делится пополам,
+    // пока не станет не больше grain; половины уходят в очередь и могут быть украдены.
+    // width ограничивает число потоков пула, одновременно занятых циклом: тогда
+    // в очередь ставится width исполнителей, которые разбирают порции grain по общему счетчику.
+    // Исключение из body пробрасывается вызывающему.
+    void parallelFor(size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& body,
+                     int width = INT_MAX) {
+        if (begin >= end) {
+            return;
+        }
+        auto loop = make_shared<LoopState>();
+        loop->body = &body;
+        loop->grain = max<size_t>(grain, 1);
+        loop->remaining = end - begin;
+        if (width >= size()) {
+            push([this, loop, begin, end] { runRange(loop, begin, end); });
+        } else {
+            loop->next = begin;
+            loop->end = end;
+            // Вызывающий поток пула сам становится одним из исполнителей
+            const int runners = currentPool == this ? max(width, 1) - 1 : max(width, 1);
+            for (int r = 0; r < runners; ++r) {
+                push([loop] { runShared(loop); });
+            }
+            if (currentPool == this) {
+                runShared(loop);
+            }
+        }
+
+        if (currentPool == this) {
+            // Вложенный вызов из задачи пула: помогаем, иначе возможна взаимная блокировка
+            while (loop->remaining.load(memory_order_acquire) != 0) {
+                if (!runOne(currentIndex)) {
+                    this_thread::yield();
+                }
+            }
+        } else {
+            unique_lock<mutex> lock(loop->doneMutex);
+            loop->done.wait(lock, [&] { return loop->remaining.load(memory_order_acquire) == 0; });
+        }
+        if (loop->failed.load(memory_order_acquire)) {
+            rethrow_exception(loop->error);
+        }
+    }
+
+private:
+    struct alignas(64) WorkerQueue {
+        mutex m;
+        deque<function<void()>> tasks;
+    };
+
+    struct LoopState {
+        const function<void(size_t, size_t)>* body = nullptr;
+        size_t grain = 1;
+        atomic<size_t> remaining{0};
+        mutex doneMutex;
+        condition_variable done;
+        once_flag errorOnce;
+        exception_ptr error;           // Пишется один раз под errorOnce
+        atomic<bool> failed{false};    // Поднимается после записи error; его читают другие задачи
+        atomic<size_t> next{0};        // Начало следующей порции при ограниченной ширине
+        size_t end = 0;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<thread> workers;
+    mutex sleepMutex;
+    condition_variable wake;
+    atomic<size_t> pending{0};
+    bool stopping = false;
+    atomic<size_t> nextQueue{0};
+
+    inline static thread_local ThreadPool* currentPool = nullptr;
+    inline static thread_local int currentIndex = -1;
+
+    void push(function<void()> task) {
+        size_t index = currentPool == this ? static_cast<size_t>(currentIndex)
+                                           : nextQueue.fetch_add(1, memory_order_relaxed) % queues.size();
+        {
+            lock_guard<mutex> lock(queues[index]->m);
+            queues[index]->tasks.push_back(move(task));
+        }
+        pending.fetch_add(1, memory_order_release);
+        {
+            lock_guard<mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // Своя задача с конца очереди, иначе кража с начала чужой
+    bool runOne(int self) {
+        function<void()> task;
+        const size_t count = queues.size();
+        for (size_t k = 0; k < count && !task; ++k) {
+            size_t index = (static_cast<size_t>(self) + k) % count;
+            lock_guard<mutex> lock(queues[index]->m);
+            auto& tasks = queues[index]->tasks;
+            if (!tasks.empty()) {
+                if (k == 0) {
+                    task = move(tasks.back());
+                    tasks.pop_back();
+                } else {
+                    task = move(tasks.front());
+                    tasks.pop_front();
+                }
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        pending.fetch_sub(1, memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    void runRange(const shared_ptr<LoopState>& loop, size_t begin, size_t end) {
+        while (end - begin > loop->grain) {
+            size_t middle = begin + (end - begin) / 2;
+            push([this, loop, middle, end] { runRange(loop, middle, end); });
+            end = middle;
+        }
+        runBody(*loop, begin, end);
+    }
+
+    // Исполнитель цикла ограниченной ширины; опоздавший исполнитель не находит порций и выходит
+    static void runShared(const shared_ptr<LoopState>& loop) {
+        for (;;) {
+            size_t begin = loop->next.fetch_add(loop->grain, memory_order_relaxed);
+            if (begin >= loop->end) {
+                return;
+            }
+            runBody(*loop, begin, min(loop->end, begin + loop->grain));
+        }
+    }
+
+    static void runBody(LoopState& loop, size_t begin, size_t end) {
+        try {
+            if (!loop.failed.load(memory_order_acquire)) {
+                (*loop.body)(begin, end);
+            }
+        } catch (...) {
+            call_once(loop.errorOnce, [&] {
+                loop.error = current_exception();
+                loop.failed.store(true, memory_order_release);
+            });
+        }
+        if (loop.remaining.fetch_sub(end - begin, memory_order_acq_rel) == end - begin) {
+            lock_guard<mutex> lock(loop.doneMutex);
+            loop.done.notify_all();
+        }
+    }
+
+    void workerLoop(int index) {
+        currentPool = this;
+        currentIndex = index;
+        for (;;) {
+            if (runOne(index)) {
+                continue;
+            }
+            unique_lock<mutex> lock(sleepMutex);
+            wake.wait(lock, [&] { return stopping || pending.load(memory_order_acquire) > 0; });
+            if (stopping && pending.load(memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+};
+
+// Общий пул с заданной шириной: циклы занимают не больше width его потоков
+class PoolView {
+public:
+    PoolView(ThreadPool& pool, int width) : pool(&pool), width(width) {}
+
+    int size() const {
+        return width;
+    }
+
+    void parallelFor(size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& body) const {
+        pool->parallelFor(begin, end, grain, body, width);
+    }
+
+private:
+    ThreadPool* pool;
+    int width;
+};
+
+// Общий пул для повторных запросов. Пул один на процесс и только растет: сразу
+// создается по числу процессоров, а запросы разной ширины делят его потоки.
+// Внутри задачи пула он не растет, чтобы не разрушить пул под ногами вызывающего.
+PoolView sharedPool(int numThreads) {
+    static unique_ptr<ThreadPool> pool;
+    numThreads = max(numThreads, 1);
+    if (!pool) {
+        pool.reset(new ThreadPool(max(numThreads, static_cast<int>(thread::hardware_concurrency()))));
+    } else if (pool->size() < numThreads && !ThreadPool::insidePool()) {
+        pool.reset();
+        pool.reset(new ThreadPool(numThreads));
+    }
+    return PoolView(*pool, min(numThreads, pool->size()));
+}
+
+// Размер порции для пула: записей в строковом виде и слов маски в колоночном
+const size_t TRAINING_GRAIN = 16384;
+const size_t BITMAP_GRAIN_WORDS = 1024;
+
+// Функция обработки данных с использованием многопоточности:
+// номера подходящих записей складываются в собственный буфер порции
+void processWithThreads(const vector<Training>& trainings, int dayOfWeek, vector<uint32_t>& matches, size_t start, size_t end) {
+    matches.clear();
+    for (size_t i = start; i < end; ++i) {
+        if (isTrainingOnDay(trainings[i], dayOfWeek)) {
+            matches.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// Функция для выполнения многопоточной обработки на общем пуле.
+// Без блокировок: порции фильтруются в свои буферы, префиксная сумма дает каждой
+// место в общем массиве, затем порции параллельно копируются. Порядок как у
+// последовательного прохода.
+void multiThreadedProcessing(const vector<Training>& trainings, int dayOfWeek, vector<Training>& results, int numThreads) {
+    PoolView pool = sharedPool(numThreads);
+    const size_t chunks = (trainings.size() + TRAINING_GRAIN - 1) / TRAINING_GRAIN;
+    vector<vector<uint32_t>> matches(chunks);
+
+    pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            processWithThreads(trainings, dayOfWeek, matches[c], c * TRAINING_GRAIN,
+                               min(trainings.size(), (c + 1) * TRAINING_GRAIN));
+        }
+    });
+
+    vector<size_t> offsets(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        offsets[c] = matches[c].size();
+    }
+    size_t base = results.size();
+    results.resize(base + exclusivePrefixSum(offsets));
+
+    pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            Training* out = results.data() + base + offsets[c];
+            for (uint32_t row : matches[c]) {
+                *out++ = trainings[row];
+            }
+        }
+    });
+}
+
+// Параллельная колоночная выборка: порции по границам слов маски, затем та же
+// префиксная сумма и запись номеров строк каждой порцией на свое место
+void parallelFilterRows(const TrainingView& view, const TrainingQuery& query, vector<uint32_t>& rows, int numThreads,
+                        const FilterKernels& kernels = filterKernels(SimdLevel::Avx512)) {
+    PoolView pool = sharedPool(numThreads);
+    const size_t words = (view.size + 63) / 64;
+    const size_t chunks = (words + BITMAP_GRAIN_WORDS - 1) / BITMAP_GRAIN_WORDS;
+    vector<uint64_t> bitmap(words);
+    vector<size_t> offsets(chunks, 0);
+
+    pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        vector<uint64_t> local;
+        for (size_t c = first; c < last; ++c) {
+            size_t begin = c * BITMAP_GRAIN_WORDS * 64;
+            size_t end = min(view.size, begin + BITMAP_GRAIN_WORDS * 64);
+            selectRows(view.slice(begin, end - begin), query, local, kernels);
+            copy(local.begin(), local.end(), bitmap.begin() + c * BITMAP_GRAIN_WORDS);
+            for (uint64_t word : local) {
+                offsets[c] += static_cast<size_t>(__builtin_popcountll(word));
+            }
+        }
+    });
+
+    rows.resize(exclusivePrefixSum(offsets));
+    pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            uint32_t* out = rows.data() + offsets[c];
+            size_t endWord = min(words, (c + 1) * BITMAP_GRAIN_WORDS);
+            for (size_t w = c * BITMAP_GRAIN_WORDS; w < endWord; ++w) {
+                for (uint64_t word = bitmap[w]; word != 0; word &= word - 1) {
+                    *out++ = static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+                }
+            }
+        }
+    });
+}
+
+// Число тренировок дня недели D без копирования записей (режим только подсчета)
+size_t multiThreadedCount(const vector<Training>& trainings, int dayOfWeek, int numThreads) {
+    const size_t chunks = (trainings.size() + TRAINING_GRAIN - 1) / TRAINING_GRAIN;
+    vector<size_t> counts(chunks);
+    sharedPool(numThreads).parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            size_t count = 0;
+            for (size_t i = c * TRAINING_GRAIN; i < min(trainings.size(), (c + 1) * TRAINING_GRAIN); ++i) {
+                count += isTrainingOnDay(trainings[i], dayOfWeek);
+            }
+            counts[c] = count;
+        }
+    });
+    return exclusivePrefixSum(counts);
+}
+
+// Ячеек сводки на одного тренера: день недели x час
+const size_t AGGREGATE_CELLS = 7 * 24;
+
+// Сводка: число тренировок по (тренер, день недели, час начала)
+struct TrainingAggregate {
+    CoachDictionary coaches;
+    vector<uint64_t> counts; // [тренер][день недели][час]
+
+    uint64_t count(size_t coach, int dayOfWeek, int hour) const {
+        return counts[coach * AGGREGATE_CELLS + static_cast<size_t>(dayOfWeek) * 24 + static_cast<size_t>(hour)];
+    }
+
+    // Занятия тренера в день недели
+    uint64_t coachWeekday(size_t coach, int dayOfWeek) const {
+        uint64_t sum = 0;
+        for (int hour = 0; hour < 24; ++hour) {
+            sum += count(coach, dayOfWeek, hour);
+        }
+        return sum;
+    }
+
+    // Нагрузка по часу суток
+    uint64_t hourLoad(int hour) const {
+        uint64_t sum = 0;
+        for (size_t coach = 0; coach < coaches.names.size(); ++coach) {
+            for (int day = 0; day < 7; ++day) {
+                sum += count(coach, day, hour);
+            }
+        }
+        return sum;
+    }
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (uint64_t value : counts) {
+            sum += value;
+        }
+        return sum;
+    }
+};
+
+// Аллокатор, выдающий память с начала кэш-линии
+template <typename T>
+struct CacheLineAllocator {
+    using value_type = T;
+
+    CacheLineAllocator() = default;
+    template <typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(64)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(64));
+    }
+
+    template <typename U>
+    bool operator==(const CacheLineAllocator<U>&) const { return true; }
+};
+
+using AlignedCounts = vector<uint64_t, CacheLineAllocator<uint64_t>>;
+
+// Частная таблица порции. Таблицу выделяет и заполняет только свой поток;
+// она начинается с кэш-линии и округлена до целых линий, поэтому соседние таблицы не делят линию.
+struct alignas(64) AggregateSlice {
+    AlignedCounts counts;
+    CoachDictionary coaches; // Только для строковых записей: локальные номера тренеров
+
+    void reset(size_t cells) {
+        counts.assign((cells + 7) / 8 * 8, 0);
+    }
+
+    // Ячейки тренера coach; таблица растет при появлении нового тренера
+    uint64_t* coachCells(uint16_t coach) {
+        size_t need = (static_cast<size_t>(coach) + 1) * AGGREGATE_CELLS;
+        if (counts.size() < need) {
+            counts.resize((need + 7) / 8 * 8, 0);
+        }
+        return counts.data() + static_cast<size_t>(coach) * AGGREGATE_CELLS;
+    }
+};
+
+// Порций больше, чем потоков, чтобы пул мог выровнять нагрузку; не меньше TRAINING_GRAIN строк в порции
+size_t aggregateSlices(size_t rows, const PoolView& pool) {
+    return max<size_t>(1, min((rows + TRAINING_GRAIN - 1) / TRAINING_GRAIN, static_cast<size_t>(pool.size()) * 2));
+}
+
+// Слияние частных таблиц деревом: в раунде step таблица i + step прибавляется к i,
+// пары раунда складываются параллельно; итог - в slices[0]
+void mergeAggregateSlices(vector<AggregateSlice>& slices, size_t cells, const PoolView& pool) {
+    for (size_t step = 1; step < slices.size(); step *= 2) {
+        const size_t pairs = (slices.size() + 2 * step - 1) / (2 * step);
+        pool.parallelFor(0, pairs, 1, [&](size_t first, size_t last) {
+            for (size_t p = first; p < last; ++p) {
+                size_t target = p * 2 * step;
+                if (target + step >= slices.size()) {
+                    continue;
+                }
+                const uint64_t* from = slices[target + step].counts.data();
+                uint64_t* to = slices[target].counts.data();
+                for (size_t k = 0; k < cells; ++k) {
+                    to[k] += from[k];
+                }
+            }
+        });
+    }
+}
+
+// Сводка по колонкам за один параллельный проход: строки выбираются ядрами
+// фильтра, каждая порция считает в свою плотную таблицу, затем слияние деревом
+TrainingAggregate aggregateRows(const TrainingView& view, const CoachDictionary& dictionary, const TrainingQuery& query,
+                                int numThreads, const FilterKernels& kernels = filterKernels(SimdLevel::Avx512)) {
+    PoolView pool = sharedPool(numThreads);
+    const size_t coachCount = dictionary.names.size();
+    const size_t cells = coachCount * AGGREGATE_CELLS;
+    // Порции по границам слов маски, чтобы ядра работали с целыми словами
+    const size_t words = (view.size + 63) / 64;
+    vector<AggregateSlice> slices(aggregateSlices(view.size, pool));
+
+    pool.parallelFor(0, slices.size(), 1, [&](size_t first, size_t last) {
+        vector<uint64_t> bitmap;
+        for (size_t s = first; s < last; ++s) {
+            AggregateSlice& slice = slices[s];
+            slice.reset(cells);
+            size_t begin = words * s / slices.size() * 64;
+            size_t end = min(view.size, words * (s + 1) / slices.size() * 64);
+            selectRows(view.slice(begin, end - begin), query, bitmap, kernels);
+            for (size_t w = 0; w < bitmap.size(); ++w) {
+                for (uint64_t word = bitmap[w]; word != 0; word &= word - 1) {
+                    size_t row = begin + w * 64 + static_cast<size_t>(__builtin_ctzll(word));
+                    // Номер тренера, день и время проверены при загрузке набора (MappedDataset::validate)
+                    ++slice.counts[view.coaches[row] * AGGREGATE_CELLS +
+                                   static_cast<size_t>(weekdayFromDays(view.days[row])) * 24 + view.minutes[row] / 60u];
+                }
+            }
+        }
+    });
+
+    mergeAggregateSlices(slices, cells, pool);
+    TrainingAggregate result;
+    result.coaches = dictionary;
+    result.counts.assign(slices[0].counts.begin(), slices[0].counts.begin() + static_cast<ptrdiff_t>(cells));
+    return result;
+}
+
+// Сводка по строковым записям (тем же данным, что просматривает multiThreadedProcessing)
+// без копирования Training. Порции ведут свои словари тренеров; перед слиянием
+// локальные номера по порядку порций переводятся в общий словарь, поэтому номера
+// тренеров те же, что при последовательном проходе. dayOfWeek < 0 - все дни.
+TrainingAggregate aggregateTrainings(const vector<Training>& trainings, int dayOfWeek, int numThreads) {
+    PoolView pool = sharedPool(numThreads);
+    vector<AggregateSlice> slices(aggregateSlices(trainings.size(), pool));
+
+    pool.parallelFor(0, slices.size(), 1, [&](size_t first, size_t last) {
+        for (size_t s = first; s < last; ++s) {
+            AggregateSlice& slice = slices[s];
+            slice.reset(0);
+            size_t end = trainings.size() * (s + 1) / slices.size();
+            for (size_t i = trainings.size() * s / slices.size(); i < end; ++i) {
+                const Training& training = trainings[i];
+                int32_t day = 0;
+                uint16_t minute = 0;
+                if (!parseDate(training.date.data(), training.date.size(), day) ||
+                    !parseTime(training.time.data(), training.time.size(), minute)) {
+                    continue;
+                }
+                int weekday = weekdayFromDays(day);
+                if (dayOfWeek >= 0 && weekday != dayOfWeek) {
+                    continue;
+                }
+                ++slice.coachCells(slice.coaches.intern(training.coachName))[weekday * 24 + minute / 60];
+            }
+        }
+    });
+
+    TrainingAggregate result;
+    vector<vector<uint16_t>> remaps(slices.size());
+    for (size_t s = 0; s < slices.size(); ++s) {
+        for (const auto& name : slices[s].coaches.names) {
+            remaps[s].push_back(result.coaches.intern(name));
         }
     }
+    const size_t cells = result.coaches.names.size() * AGGREGATE_CELLS;
+    pool.parallelFor(0, slices.size(), 1, [&](size_t first, size_t last) {
+        for (size_t s = first; s < last; ++s) {
+            AlignedCounts local;
+            local.swap(slices[s].counts);
+            slices[s].reset(cells);
+            for (size_t k = 0; k < remaps[s].size(); ++k) {
+                copy_n(local.begin() + static_cast<ptrdiff_t>(k * AGGREGATE_CELLS), AGGREGATE_CELLS,
+                       slices[s].counts.begin() + static_cast<ptrdiff_t>(remaps[s][k] * AGGREGATE_CELLS));
+            }
+        }
+    });
+
+    mergeAggregateSlices(slices, cells, pool);
+    result.counts.assign(slices[0].counts.begin(), slices[0].counts.begin() + static_cast<ptrdiff_t>(cells));
+    return result;
 }
 
-// Функция для выполнения многопоточной обработки
-void multiThreadedProcessing(const vector<Training>& trainings, int dayOfWeek, vector<Training>& results, int numThreads) {
-    vector<thread> threads;
-    size_t trainingsPerThread = trainings.size() / numThreads;
+// Печать сводки: занятия тренеров по дням недели и нагрузка по часам
+void printAggregate(const TrainingAggregate& aggregate) {
+    static const char* const weekdays[] = {"Вс", "Пн", "Вт", "Ср", "Чт", "Пт", "Сб"};
+    cout << "Тренер";
+    for (const char* day : weekdays) {
+        cout << "\t" << day;
+    }
+    cout << "\n";
+    for (size_t coach = 0; coach < aggregate.coaches.names.size(); ++coach) {
+        cout << aggregate.coaches.name(static_cast<uint16_t>(coach));
+        for (int day = 0; day < 7; ++day) {
+            cout << "\t" << aggregate.coachWeekday(coach, day);
+        }
+        cout << "\n";
+    }
+    cout << "Час\tЗанятий\n";
+    for (int hour = 0; hour < 24; ++hour) {
+        cout << hour << "\t" << aggregate.hourLoad(hour) << "\n";
+    }
+}
+
+// Буфер форматирования строк результата: память переиспользуется между порциями,
+// выравнивание не дает буферам соседних потоков делить кэш-линию
+struct alignas(64) RowBuffer {
+    vector<char> data;
+    size_t used = 0;
+
+    // Место под bytes байт в конце буфера; занятая часть фиксируется через commit
+    char* reserve(size_t bytes) {
+        if (used + bytes > data.size()) {
+            data.resize(max(data.size() * 2, used + bytes));
+        }
+        return data.data() + used;
+    }
+
+    void commit(size_t bytes) {
+        used += bytes;
+    }
+
+    // Строка "дата время тренер\n" без временных string
+    void appendRow(int32_t day, uint16_t minute, const string& coach) {
+        char* out = reserve(32 + coach.size());
+        size_t length = formatDate(day, out);
+        out[length++] = ' ';
+        length += formatTime(minute, out + length);
+        out[length++] = ' ';
+        memcpy(out + length, coach.data(), coach.size());
+        length += coach.size();
+        out[length++] = '\n';
+        commit(length);
+    }
+
+    void appendRow(const Training& training) {
+        char* out = reserve(training.date.size() + training.time.size() + training.coachName.size() + 3);
+        char* p = out;
+        p = copy(training.date.begin(), training.date.end(), p);
+        *p++ = ' ';
+        p = copy(training.time.begin(), training.time.end(), p);
+        *p++ = ' ';
+        p = copy(training.coachName.begin(), training.coachName.end(), p);
+        *p++ = '\n';
+        commit(static_cast<size_t>(p - out));
+    }
+};
+
+// Строк результата в одной порции форматирования и буферов одного writev (IOV_MAX в Linux)
+const size_t OUTPUT_GRAIN_ROWS = 16384;
+const size_t OUTPUT_MAX_IOVECS = 1024;
+
+// Пакетный вывод результатов в файловый дескриптор. Порции строк форматируются
+// параллельно на общем пуле в собственные буферы и выводятся по порядку одним
+// writev на партию порций - вместо записи и сброса на каждую строку.
+class ResultWriter {
+public:
+    explicit ResultWriter(int fd = STDOUT_FILENO) : fd(fd) {
+        cout.flush(); // Все, что уже напечатано через cout, должно выйти раньше строк результата
+    }
+
+    // Строки колоночного набора с номерами rows
+    void writeRows(const TrainingView& view, const CoachDictionary& dictionary, const vector<uint32_t>& rows,
+                   int numThreads) {
+        writeChunks(rows.size(), numThreads, [&](RowBuffer& buffer, size_t i) {
+            uint32_t row = rows[i];
+            buffer.appendRow(view.days[row], view.minutes[row], dictionary.name(view.coaches[row]));
+        });
+    }
+
+    void writeTrainings(const vector<Training>& trainings, int numThreads) {
+        writeChunks(trainings.size(), numThreads, [&](RowBuffer& buffer, size_t i) {
+            buffer.appendRow(trainings[i]);
+        });
+    }
+
+    size_t bytesWritten() const {
+        return written;
+    }
+
+    // Число системных вызовов записи
+    size_t writeCalls() const {
+        return calls;
+    }
+
+private:
+    int fd;
+    vector<RowBuffer> buffers;
+    size_t written = 0;
+    size_t calls = 0;
+
+    // В одном потоке порции форматируются на месте, без обращения к общему пулу
+    template <typename Format>
+    void writeChunks(size_t count, int numThreads, Format&& format) {
+        const size_t chunks = (count + OUTPUT_GRAIN_ROWS - 1) / OUTPUT_GRAIN_ROWS;
+        const size_t batch = min(static_cast<size_t>(max(numThreads, 1)) * 4, OUTPUT_MAX_IOVECS);
+        buffers.resize(batch);
+        for (size_t start = 0; start < chunks; start += batch) {
+            const size_t n = min(batch, chunks - start);
+            auto formatBuffers = [&](size_t first, size_t last) {
+                for (size_t b = first; b < last; ++b) {
+                    RowBuffer& buffer = buffers[b];
+                    buffer.used = 0;
+                    size_t end = min(count, (start + b + 1) * OUTPUT_GRAIN_ROWS);
+                    for (size_t i = (start + b) * OUTPUT_GRAIN_ROWS; i < end; ++i) {
+                        format(buffer, i);
+                    }
+                }
+            };
+            if (numThreads <= 1) {
+                formatBuffers(0, n);
+            } else {
+                sharedPool(numThreads).parallelFor(0, n, 1, formatBuffers);
+            }
+            vector<iovec> parts(n);
+            for (size_t b = 0; b < n; ++b) {
+                parts[b] = {buffers[b].data.data(), buffers[b].used};
+            }
+            writeAll(parts);
+        }
+    }
+
+    // writev с дозаписью после частичной записи и повтором после EINTR
+    void writeAll(vector<iovec>& parts) {
+        iovec* part = parts.data();
+        iovec* end = parts.data() + parts.size();
+        while (part != end) {
+            if (part->iov_len == 0) {
+                ++part;
+                continue;
+            }
+            ssize_t result = writev(fd, part, static_cast<int>(end - part));
+            ++calls;
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw runtime_error(string("ошибка вывода результатов: ") + strerror(errno));
+            }
+            size_t done = static_cast<size_t>(result);
+            written += done;
+            for (; part != end && done >= part->iov_len; ++part) {
+                done -= part->iov_len;
+            }
+            if (part != end) {
+                part->iov_base = static_cast<char*>(part->iov_base) + done;
+                part->iov_len -= done;
+            }
+        }
+    }
+};
+
+// Параллельная сортировка ключей: порции сортируются независимо, затем сливаются
+// попарно раундами, в каждом раунде пары сливаются параллельно
+void parallelSort(vector<uint64_t>& keys, int numThreads) {
+    PoolView pool = sharedPool(numThreads);
+    const size_t chunks = (keys.size() + TRAINING_GRAIN - 1) / TRAINING_GRAIN;
+    pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            sort(keys.begin() + c * TRAINING_GRAIN, keys.begin() + min(keys.size(), (c + 1) * TRAINING_GRAIN));
+        }
+    });
+    vector<uint64_t> buffer(keys.size());
+    for (size_t width = TRAINING_GRAIN; width < keys.size(); width *= 2) {
+        const size_t pairs = (keys.size() + 2 * width - 1) / (2 * width);
+        pool.parallelFor(0, pairs, 1, [&](size_t first, size_t last) {
+            for (size_t p = first; p < last; ++p) {
+                size_t begin = p * 2 * width;
+                size_t middle = min(keys.size(), begin + width);
+                size_t end = min(keys.size(), begin + 2 * width);
+                merge(keys.begin() + begin, keys.begin() + middle, keys.begin() + middle, keys.begin() + end,
+                      buffer.begin() + begin);
+            }
+        });
+        keys.swap(buffer);
+    }
+}
+
+// Индекс по дням недели и датам для повторных запросов к одному набору данных.
+// Для каждого дня недели - номера строк по возрастанию, для дат - строки,
+// упорядоченные по (дата, номер) в одном 64-битном ключе. Запрос стоит
+// O(совпадений) вместо O(N); новые строки дописываются без полной перестройки.
+class TrainingIndex {
+public:
+    // Части индекса можно отключить, чтобы сэкономить память ценой скорости запросов
+    explicit TrainingIndex(bool withWeekdays = true, bool withDates = true)
+        : withWeekdays(withWeekdays), withDates(withDates) {}
+
+    // Индексация строк [size(), view.size): при первом вызове - весь набор
+    void append(const TrainingView& view, int numThreads) {
+        const size_t base = indexedRows;
+        if (view.size <= base) {
+            return;
+        }
+        if (withWeekdays) {
+            appendWeekdays(view, base, numThreads);
+        }
+        if (withDates) {
+            appendDates(view, base, numThreads);
+        }
+        indexedRows = view.size;
+    }
+
+    size_t size() const {
+        return indexedRows;
+    }
+
+    // Память, занятая индексом, в байтах
+    size_t memoryBytes() const {
+        size_t bytes = byDate.capacity() * sizeof(uint64_t);
+        for (const auto& rows : byWeekday) {
+            bytes += rows.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+    // Выборка по запросу. Кандидаты берутся из самой узкой части индекса
+    // (список дня недели или отрезок дат), остальные условия проверяются построчно.
+    // Результат - номера строк по возрастанию, как у filterRows. false - индекс
+    // не покрывает запрос (нет нужной части или набор вырос) и нужен полный проход.
+    bool query(const TrainingView& view, const TrainingQuery& query, vector<uint32_t>& rows) const {
+        rows.clear();
+        if (view.size != indexedRows) {
+            return false;
+        }
+        const bool useWeekday = withWeekdays && query.hasWeekday();
+        const bool useDates = withDates && query.hasDayRange();
+        if (!useWeekday && !useDates) {
+            return false;
+        }
+        auto first = byDate.begin(), last = byDate.begin();
+        if (useDates && query.fromDay <= query.toDay) {
+            first = lower_bound(byDate.begin(), byDate.end(), dateKey(query.fromDay, 0));
+            last = upper_bound(first, byDate.end(), dateKey(query.toDay, UINT32_MAX));
+        }
+        const vector<uint32_t>* weekdayRows = useWeekday ? &byWeekday[query.dayOfWeek] : nullptr;
+        if (weekdayRows && (!useDates || weekdayRows->size() <= static_cast<size_t>(last - first))) {
+            for (uint32_t row : *weekdayRows) {
+                if (matchesQuery(view, row, query)) {
+                    rows.push_back(row);
+                }
+            }
+            return true;
+        }
+        for (auto it = first; it != last; ++it) {
+            uint32_t row = static_cast<uint32_t>(*it);
+            if (matchesQuery(view, row, query)) {
+                rows.push_back(row);
+            }
+        }
+        sort(rows.begin(), rows.end());
+        return true;
+    }
+
+private:
+    bool withWeekdays;
+    bool withDates;
+    size_t indexedRows = 0;
+    vector<uint32_t> byWeekday[7];
+    vector<uint64_t> byDate;
+
+    // Ключ сортировки: дата со сдвигом знака в старших битах, номер строки в младших
+    static uint64_t dateKey(int32_t day, uint32_t row) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(day) ^ 0x80000000u) << 32 | row;
+    }
+
+    // Подсчет по порциям, префиксная сумма и раскладка каждой порцией на свое место
+    void appendWeekdays(const TrainingView& view, size_t base, int numThreads) {
+        PoolView pool = sharedPool(numThreads);
+        const size_t chunks = (view.size - base + TRAINING_GRAIN - 1) / TRAINING_GRAIN;
+        vector<size_t> offsets[7];
+        for (auto& counts : offsets) {
+            counts.assign(chunks, 0);
+        }
+        pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                size_t end = min(view.size, base + (c + 1) * TRAINING_GRAIN);
+                for (size_t row = base + c * TRAINING_GRAIN; row < end; ++row) {
+                    ++offsets[weekdayFromDays(view.days[row])][c];
+                }
+            }
+        });
+        size_t starts[7];
+        for (int d = 0; d < 7; ++d) {
+            starts[d] = byWeekday[d].size();
+            byWeekday[d].resize(starts[d] + exclusivePrefixSum(offsets[d]));
+        }
+        pool.parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                uint32_t* out[7];
+                for (int d = 0; d < 7; ++d) {
+                    out[d] = byWeekday[d].data() + starts[d] + offsets[d][c];
+                }
+                size_t end = min(view.size, base + (c + 1) * TRAINING_GRAIN);
+                for (size_t row = base + c * TRAINING_GRAIN; row < end; ++row) {
+                    *out[weekdayFromDays(view.days[row])]++ = static_cast<uint32_t>(row);
+                }
+            }
+        });
+    }
+
+    // Новые ключи сортируются отдельно и сливаются с уже упорядоченными
+    void appendDates(const TrainingView& view, size_t base, int numThreads) {
+        vector<uint64_t> added(view.size - base);
+        sharedPool(numThreads).parallelFor(0, added.size(), TRAINING_GRAIN, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                added[i] = dateKey(view.days[base + i], static_cast<uint32_t>(base + i));
+            }
+        });
+        parallelSort(added, numThreads);
+        if (byDate.empty()) {
+            byDate.swap(added);
+            return;
+        }
+        const size_t middle = byDate.size();
+        byDate.insert(byDate.end(), added.begin(), added.end());
+        inplace_merge(byDate.begin(), byDate.begin() + middle, byDate.end());
+    }
+};
+
+// Перемешивание SplitMix64: превращает пользовательское зерно в состояние генератора
+uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Генератор PCG32 (XSH RR) с переходом вперед за O(log n). Порции набора данных
+// берут непересекающиеся участки одной последовательности, поэтому результат
+// зависит только от зерна, а не от числа потоков и разбиения на порции.
+class Pcg32 {
+public:
+    explicit Pcg32(uint64_t seed) {
+        uint64_t mix = seed;
+        state = splitMix64(mix);
+        increment = splitMix64(mix) | 1;
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * MULTIPLIER + increment;
+        uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = static_cast<uint32_t>(old >> 59);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    // Число в [0, bound), bound <= 2^32; ровно одно значение генератора на вызов
+    uint32_t below(uint64_t bound) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+    }
+
+    // Пропуск delta значений: степень линейного преобразования двоичным возведением
+    void advance(uint64_t delta) {
+        uint64_t accMultiplier = 1, accIncrement = 0;
+        uint64_t multiplier = MULTIPLIER, step = increment;
+        for (; delta != 0; delta >>= 1) {
+            if (delta & 1) {
+                accMultiplier *= multiplier;
+                accIncrement = accIncrement * multiplier + step;
+            }
+            step = (multiplier + 1) * step;
+            multiplier *= multiplier;
+        }
+        state = accMultiplier * state + accIncrement;
+    }
+
+private:
+    static constexpr uint64_t MULTIPLIER = 6364136223846793005ull;
+    uint64_t state;
+    uint64_t increment;
+};
+
+// Тренеры, из которых выбирает генератор
+const vector<string> GENERATED_COACHES = {"Иванов И.И.", "Петров П.П.", "Сидоров С.С.", "Кузнецов А.А.", "Смирнов В.В."};
+
+// Значений генератора на одну запись: день, час, минута, тренер
+const uint64_t GENERATOR_DRAWS = 4;
+
+// Диапазон дат генерации
+void parseDateRange(const string& startDate, const string& endDate, int32_t& startDay, int32_t& endDay) {
+    if (!parseDate(startDate.data(), startDate.size(), startDay) || !parseDate(endDate.data(), endDate.size(), endDay) ||
+        startDay > endDay) {
+        throw invalid_argument("некорректный диапазон дат: " + startDate + " - " + endDate);
+    }
+}
+
+// Запись с номером row последовательности зерна seed попадает в [begin, end):
+// генератор переводится на начало порции, дальше каждая запись берет GENERATOR_DRAWS значений
+template <typename Emit>
+void generateRows(uint64_t seed, size_t begin, size_t end, int32_t startDay, int32_t endDay, Emit&& emit) {
+    Pcg32 gen(seed);
+    gen.advance(begin * GENERATOR_DRAWS);
+    const uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(endDay) - startDay) + 1;
+    for (size_t i = begin; i < end; ++i) {
+        int32_t day = static_cast<int32_t>(startDay + static_cast<int64_t>(gen.below(span)));
+        uint32_t hour = gen.below(24);
+        uint32_t minute = gen.below(60);
+        uint32_t coach = gen.below(GENERATED_COACHES.size());
+        emit(i, day, static_cast<uint16_t>(hour * 60 + minute), coach);
+    }
+}
+
+// Генерация прямо в колонки: память выделяется один раз, записи без временных строк.
+// Для одного зерна результат побитово одинаков при любом числе потоков.
+void generateTrainingColumns(TrainingColumns& columns, size_t count, int32_t startDay, int32_t endDay, uint64_t seed,
+                             int numThreads = 1) {
+    if (columns.size() + count > UINT32_MAX) {
+        throw invalid_argument("слишком много строк для 32-битных номеров");
+    }
+    vector<uint16_t> ids(GENERATED_COACHES.size());
+    for (size_t k = 0; k < GENERATED_COACHES.size(); ++k) {
+        ids[k] = columns.dictionary.intern(GENERATED_COACHES[k]);
+    }
+    const size_t base = columns.size();
+    const size_t chunks = (count + TRAINING_GRAIN - 1) / TRAINING_GRAIN;
+    columns.days.resize(base + count);
+    columns.minutes.resize(base + count);
+    columns.coaches.resize(base + count);
+    int32_t* days = columns.days.data() + base;
+    uint16_t* minutes = columns.minutes.data() + base;
+    uint16_t* coaches = columns.coaches.data() + base;
+
+    sharedPool(numThreads).parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            generateRows(seed, c * TRAINING_GRAIN, min(count, (c + 1) * TRAINING_GRAIN), startDay, endDay,
+                         [&](size_t i, int32_t day, uint16_t minute, uint32_t coach) {
+                             days[i] = day;
+                             minutes[i] = minute;
+                             coaches[i] = ids[coach];
+                         });
+        }
+    });
+}
+
+// Функция для генерации случайных данных о тренировках (порциями на общем пуле);
+// записи те же, что дает generateTrainingColumns для того же зерна
+void generateRandomTrainings(vector<Training>& trainings, int size, const string& startDate, const string& endDate,
+                             int numThreads = 1, uint64_t seed = random_device{}()) {
+    int32_t startDay = 0, endDay = 0;
+    parseDateRange(startDate, endDate, startDay, endDay);
+
+    const size_t base = trainings.size();
+    const size_t count = static_cast<size_t>(max(size, 0));
+    const size_t chunks = (count + TRAINING_GRAIN - 1) / TRAINING_GRAIN;
+    trainings.resize(base + count);
+
+    sharedPool(numThreads).parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            generateRows(seed, c * TRAINING_GRAIN, min(count, (c + 1) * TRAINING_GRAIN), startDay, endDay,
+                         [&](size_t i, int32_t day, uint16_t minute, uint32_t coach) {
+                             Training& training = trainings[base + i];
+                             char date[16];
+                             training.date.assign(date, formatDate(day, date));
+                             char time[8];
+                             training.time.assign(time, formatTime(minute, time));
+                             training.coachName = GENERATED_COACHES[coach];
+                         });
+        }
+    });
+}
+
+// Двоичный колоночный формат набора данных:
+// заголовок | days[rows] | minutes[rows] | coaches[rows] | словарь (длина uint32 + байты имени),
+// каждая секция выровнена на 64 байта; порядок байтов - родной, проверяется по byteOrder
+const char DATASET_MAGIC[8] = {'T', 'R', 'N', 'C', 'O', 'L', 'S', '\0'};
+const uint32_t DATASET_VERSION = 1;
+const uint32_t DATASET_BYTE_ORDER = 0x01020304;
+const uint64_t DATASET_ALIGN = 64;
+
+struct DatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t rowCount;
+    uint64_t daysOffset;
+    uint64_t minutesOffset;
+    uint64_t coachesOffset;
+    uint64_t dictionaryOffset;
+    uint32_t dictionaryBytes;
+    uint32_t coachCount;
+};
+static_assert(sizeof(DatasetHeader) == DATASET_ALIGN, "заголовок занимает ровно одну секцию");
+
+uint64_t alignDataset(uint64_t offset) {
+    return (offset + DATASET_ALIGN - 1) / DATASET_ALIGN * DATASET_ALIGN;
+}
+
+// Раскладка секций для заданного числа строк и размера словаря
+DatasetHeader makeDatasetHeader(uint64_t rows, const CoachDictionary& dictionary) {
+    DatasetHeader header = {};
+    memcpy(header.magic, DATASET_MAGIC, sizeof(header.magic));
+    header.version = DATASET_VERSION;
+    header.byteOrder = DATASET_BYTE_ORDER;
+    header.rowCount = rows;
+    header.daysOffset = DATASET_ALIGN;
+    header.minutesOffset = alignDataset(header.daysOffset + rows * sizeof(int32_t));
+    header.coachesOffset = alignDataset(header.minutesOffset + rows * sizeof(uint16_t));
+    header.dictionaryOffset = alignDataset(header.coachesOffset + rows * sizeof(uint16_t));
+    uint64_t dictionaryBytes = 0;
+    for (const auto& name : dictionary.names) {
+        dictionaryBytes += sizeof(uint32_t) + name.size();
+    }
+    header.dictionaryBytes = static_cast<uint32_t>(dictionaryBytes);
+    header.coachCount = static_cast<uint32_t>(dictionary.names.size());
+    return header;
+}
+
+// Дописывает нули до смещения offset
+void padDataset(ostream& out, uint64_t offset) {
+    static const char zeros[DATASET_ALIGN] = {};
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    out.write(zeros, static_cast<streamsize>(offset - position));
+}
+
+void writeDatasetDictionary(ostream& out, const CoachDictionary& dictionary) {
+    for (const auto& name : dictionary.names) {
+        uint32_t length = static_cast<uint32_t>(name.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(name.data(), static_cast<streamsize>(name.size()));
+    }
+}
+
+// Запись колонок в файл набора данных
+void writeDataset(const string& path, const TrainingColumns& columns) {
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("не удалось создать " + path);
+    }
+    DatasetHeader header = makeDatasetHeader(columns.size(), columns.dictionary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(columns.days.data()), static_cast<streamsize>(columns.size() * sizeof(int32_t)));
+    padDataset(out, header.minutesOffset);
+    out.write(reinterpret_cast<const char*>(columns.minutes.data()), static_cast<streamsize>(columns.size() * sizeof(uint16_t)));
+    padDataset(out, header.coachesOffset);
+    out.write(reinterpret_cast<const char*>(columns.coaches.data()), static_cast<streamsize>(columns.size() * sizeof(uint16_t)));
+    padDataset(out, header.dictionaryOffset);
+    writeDatasetDictionary(out, columns.dictionary);
+    if (!out.flush()) {
+        throw runtime_error("ошибка записи " + path);
+    }
+}
+
+// Набор данных, отображенный в память: колонки читаются прямо из файла,
+// при открытии разбирается только заголовок и словарь тренеров
+class MappedDataset {
+public:
+    explicit MappedDataset(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("не удалось открыть " + path + ": " + strerror(errno));
+        }
+        struct stat info = {};
+        if (fstat(fd, &info) != 0) {
+            int error = errno;
+            close(fd);
+            throw runtime_error("fstat " + path + ": " + strerror(error));
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length >= sizeof(DatasetHeader)) {
+            data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        int error = errno;
+        close(fd);
+        if (length < sizeof(DatasetHeader)) {
+            throw runtime_error(path + ": файл слишком мал для набора данных");
+        }
+        if (data == MAP_FAILED) {
+            data = nullptr;
+            throw runtime_error("mmap " + path + ": " + strerror(error));
+        }
+        try {
+            validate(path);
+        } catch (...) {
+            munmap(data, length);
+            throw;
+        }
+    }
+
+    ~MappedDataset() {
+        if (data) {
+            munmap(data, length);
+        }
+    }
+
+    MappedDataset(const MappedDataset&) = delete;
+    MappedDataset& operator=(const MappedDataset&) = delete;
+
+    TrainingView view() const {
+        const char* base = static_cast<const char*>(data);
+        return {reinterpret_cast<const int32_t*>(base + header().daysOffset),
+                reinterpret_cast<const uint16_t*>(base + header().minutesOffset),
+                reinterpret_cast<const uint16_t*>(base + header().coachesOffset),
+                static_cast<size_t>(header().rowCount)};
+    }
+
+    const CoachDictionary& coaches() const {
+        return dictionary;
+    }
+
+private:
+    void* data = nullptr;
+    size_t length = 0;
+    CoachDictionary dictionary;
+
+    const DatasetHeader& header() const {
+        return *static_cast<const DatasetHeader*>(data);
+    }
+
+    void validate(const string& path) {
+        const DatasetHeader& h = header();
+        if (memcmp(h.magic, DATASET_MAGIC, sizeof(h.magic)) != 0) {
+            throw runtime_error(path + ": не файл набора данных");
+        }
+        if (h.byteOrder != DATASET_BYTE_ORDER) {
+            throw runtime_error(path + ": другой порядок байтов");
+        }
+        if (h.version != DATASET_VERSION) {
+            throw runtime_error(path + ": неподдерживаемая версия " + to_string(h.version));
+        }
+        DatasetHeader expected = makeDatasetHeader(h.rowCount, CoachDictionary());
+        if (h.rowCount > UINT32_MAX || h.daysOffset != expected.daysOffset || h.minutesOffset != expected.minutesOffset ||
+            h.coachesOffset != expected.coachesOffset || h.dictionaryOffset != expected.dictionaryOffset ||
+            h.dictionaryOffset + h.dictionaryBytes > length) {
+            throw runtime_error(path + ": повреждена раскладка секций");
+        }
+        const char* p = static_cast<const char*>(data) + h.dictionaryOffset;
+        const char* end = p + h.dictionaryBytes;
+        for (uint32_t i = 0; i < h.coachCount; ++i) {
+            uint32_t nameLength = 0;
+            if (end - p < static_cast<ptrdiff_t>(sizeof(nameLength))) {
+                throw runtime_error(path + ": поврежден словарь тренеров");
+            }
+            memcpy(&nameLength, p, sizeof(nameLength));
+            p += sizeof(nameLength);
+            if (static_cast<size_t>(end - p) < nameLength) {
+                throw runtime_error(path + ": поврежден словарь тренеров");
+            }
+            string name(p, nameLength);
+            // Повтор имени сдвинул бы номера всех следующих тренеров
+            if (dictionary.ids.count(name) != 0) {
+                throw runtime_error(path + ": повторяющееся имя в словаре тренеров");
+            }
+            dictionary.intern(name);
+            p += nameLength;
+        }
+        // Значения колонок становятся индексами таблиц сводки и аргументами форматирования,
+        // поэтому проверяются один раз при открытии
+        const TrainingView rows = view();
+        for (size_t i = 0; i < rows.size; ++i) {
+            if (rows.days[i] < FIRST_DAY || rows.days[i] > LAST_DAY) {
+                throw runtime_error(path + ": некорректная дата в строке " + to_string(i));
+            }
+            if (rows.minutes[i] >= MINUTES_PER_DAY) {
+                throw runtime_error(path + ": некорректное время в строке " + to_string(i));
+            }
+            if (rows.coaches[i] >= h.coachCount) {
+                throw runtime_error(path + ": некорректный номер тренера в строке " + to_string(i));
+            }
+        }
+    }
+};
+
+// Итоги импорта CSV
+struct ImportStats {
+    size_t rows = 0;
+    size_t skipped = 0;   // Строки, которые не удалось разобрать
+};
+
+// Разобранная порция CSV: номера тренеров локальные, имена ссылаются на буфер блока
+struct CsvPiece {
+    vector<int32_t> days;
+    vector<uint16_t> minutes;
+    vector<uint16_t> coaches;
+    vector<string_view> names;
+    size_t skipped = 0;
+};
+
+// Разбор строк "date,time,coach" из [begin, end); строки с ошибками только подсчитываются
+void parseCsvPiece(const char* begin, const char* end, CsvPiece& piece) {
+    unordered_map<string_view, uint16_t> localIds;
+    for (const char* line = begin; line < end;) {
+        const char* newline = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+        const char* lineEnd = newline ? newline : end;
+        const char* stop = lineEnd > line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+        const char* row = line;
+        line = newline ? newline + 1 : end;
+        if (row == stop) {
+            continue;
+        }
+        const char* comma1 = static_cast<const char*>(memchr(row, ',', static_cast<size_t>(stop - row)));
+        const char* comma2 = comma1 ? static_cast<const char*>(memchr(comma1 + 1, ',', static_cast<size_t>(stop - comma1 - 1)))
+                                    : nullptr;
+        int32_t day = 0;
+        uint16_t minute = 0;
+        if (!comma2 || comma2 + 1 == stop || !parseDate(row, static_cast<size_t>(comma1 - row), day) ||
+            !parseTime(comma1 + 1, static_cast<size_t>(comma2 - comma1 - 1), minute) || piece.names.size() > UINT16_MAX) {
+            ++piece.skipped;
+            continue;
+        }
+        string_view name(comma2 + 1, static_cast<size_t>(stop - comma2 - 1));
+        auto it = localIds.find(name);
+        if (it == localIds.end()) {
+            it = localIds.emplace(name, static_cast<uint16_t>(piece.names.size())).first;
+            piece.names.push_back(name);
+        }
+        piece.days.push_back(day);
+        piece.minutes.push_back(minute);
+        piece.coaches.push_back(it->second);
+    }
+}
+
+// Размер блока чтения CSV и порции для одного потока
+const size_t CSV_BLOCK_BYTES = 16 << 20;
+const size_t CSV_PIECE_BYTES = 1 << 20;
+
+// Временные файлы колонок, удаляемые при выходе из импорта
+struct TempFiles {
+    vector<string> paths;
+    ~TempFiles() {
+        for (const auto& path : paths) {
+            remove(path.c_str());
+        }
+    }
+};
+
+// Дописывает содержимое файла path в out
+void appendFile(ostream& out, const string& path) {
+    ifstream in(path, ios::binary);
+    vector<char> buffer(1 << 20);
+    while (in.read(buffer.data(), static_cast<streamsize>(buffer.size())) || in.gcount() > 0) {
+        out.write(buffer.data(), in.gcount());
+    }
+}
+
+// Потоковый импорт CSV "date,time,coach" в двоичный набор данных.
+// Файл читается блоками, блок режется по границам строк на порции, порции
+// разбираются параллельно на общем пуле и по порядку дописываются в колонки:
+// days - сразу на место в итоговом файле, minutes и coaches - во временные файлы.
+ImportStats importCsv(const string& csvPath, const string& datasetPath, int numThreads) {
+    ifstream in(csvPath, ios::binary);
+    if (!in) {
+        throw runtime_error("не удалось открыть " + csvPath);
+    }
+    TempFiles temp;
+    temp.paths = {datasetPath + ".minutes.tmp", datasetPath + ".coaches.tmp"};
+    ofstream out(datasetPath, ios::binary | ios::trunc);
+    ofstream minutesOut(temp.paths[0], ios::binary | ios::trunc);
+    ofstream coachesOut(temp.paths[1], ios::binary | ios::trunc);
+    if (!out || !minutesOut || !coachesOut) {
+        throw runtime_error("не удалось создать " + datasetPath);
+    }
+    DatasetHeader placeholder = {};
+    out.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+
+    PoolView pool = sharedPool(numThreads);
+    CoachDictionary dictionary;
+    ImportStats stats;
+    vector<char> buffer(CSV_BLOCK_BYTES);
+    size_t carry = 0;
+    bool firstBlock = true;
+
+    for (;;) {
+        if (carry == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        in.read(buffer.data() + carry, static_cast<streamsize>(buffer.size() - carry));
+        const size_t filled = carry + static_cast<size_t>(in.gcount());
+        const bool lastBlock = !in;
+        size_t usable = filled;
+        if (!lastBlock) {
+            while (usable > 0 && buffer[usable - 1] != '\n') {
+                --usable;
+            }
+            if (usable == 0) {
+                carry = filled;
+                continue;
+            }
+        }
+
+        const char* begin = buffer.data();
+        const char* end = buffer.data() + usable;
+        if (firstBlock && usable >= 5 && memcmp(begin, "date,", 5) == 0) {
+            const char* newline = static_cast<const char*>(memchr(begin, '\n', usable));
+            begin = newline ? newline + 1 : end;
+        }
+        firstBlock = false;
+
+        vector<const char*> bounds = {begin};
+        while (bounds.back() < end) {
+            const char* cut = bounds.back() + min<size_t>(CSV_PIECE_BYTES, static_cast<size_t>(end - bounds.back()));
+            const char* newline = cut < end ? static_cast<const char*>(memchr(cut, '\n', static_cast<size_t>(end - cut))) : nullptr;
+            bounds.push_back(newline ? newline + 1 : end);
+        }
+        vector<CsvPiece> pieces(bounds.size() - 1);
+        pool.parallelFor(0, pieces.size(), 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                parseCsvPiece(bounds[i], bounds[i + 1], pieces[i]);
+            }
+        });
+
+        for (auto& piece : pieces) {
+            vector<uint16_t> remap(piece.names.size());
+            for (size_t k = 0; k < piece.names.size(); ++k) {
+                remap[k] = dictionary.intern(string(piece.names[k]));
+            }
+            for (auto& coach : piece.coaches) {
+                coach = remap[coach];
+            }
+            out.write(reinterpret_cast<const char*>(piece.days.data()), static_cast<streamsize>(piece.days.size() * sizeof(int32_t)));
+            minutesOut.write(reinterpret_cast<const char*>(piece.minutes.data()), static_cast<streamsize>(piece.minutes.size() * sizeof(uint16_t)));
+            coachesOut.write(reinterpret_cast<const char*>(piece.coaches.data()), static_cast<streamsize>(piece.coaches.size() * sizeof(uint16_t)));
+            stats.rows += piece.days.size();
+            stats.skipped += piece.skipped;
+        }
+        if (stats.rows > UINT32_MAX) {
+            throw runtime_error("слишком много строк для 32-битных номеров");
+        }
+
+        carry = filled - usable;
+        memmove(buffer.data(), buffer.data() + usable, carry);
+        if (lastBlock) {
+            break;
+        }
+    }
+
+    minutesOut.close();
+    coachesOut.close();
+    DatasetHeader header = makeDatasetHeader(stats.rows, dictionary);
+    padDataset(out, header.minutesOffset);
+    appendFile(out, temp.paths[0]);
+    padDataset(out, header.coachesOffset);
+    appendFile(out, temp.paths[1]);
+    padDataset(out, header.dictionaryOffset);
+    writeDatasetDictionary(out, dictionary);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out.flush()) {
+        throw runtime_error("ошибка записи " + datasetPath);
+    }
+    return stats;
+}
+
+// Параметры командной строки
+struct CliOptions {
+    int threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    string importPath;    // CSV для импорта
+    string outputPath;    // Файл набора данных, создаваемый импортом или генерацией
+    int generateCount = -1; // Число генерируемых записей или -1
+    uint64_t seed = random_device{}(); // Зерно генератора
+    string datasetPath;   // Файл набора данных для запроса
+    string coachName;     // Условие по тренеру (имя)
+    bool useIndex = false; // Отвечать на запрос по индексу дней недели и дат
+    bool aggregate = false; // Вместо списка записей - сводка по тренерам, дням недели и часам
+    bool quiet = false;    // Только число найденных записей и время, без самих записей
+    bool bench = false;    // Пакетный замер масштабирования вместо запроса
+    vector<int> benchSizes = {100000, 1000000, 10000000}; // Размеры наборов для замера
+    vector<int> benchThreads; // Числа потоков для замера (пусто - 1, 2, 4, ... до числа процессоров)
+    int trials = 5;        // Замеряемых прогонов
+    int warmups = 1;       // Прогревочных прогонов
+    TrainingQuery query;
+};
+
+void printUsage(const char* program) {
+    cout << "Использование: " << program << " [параметры]\n"
+         << "Без параметров - интерактивный режим.\n"
+         << "  --import=CSV          импорт файла \"date,time,coach\" (нужен --output)\n"
+         << "  --generate=N          генерация N случайных записей в диапазоне --from..--to (нужен --output)\n"
+         << "  --seed=S              зерно генератора: одно зерно - один набор при любом числе потоков\n"
+         << "  --output=ФАЙЛ         файл двоичного набора данных для импорта или генерации\n"
+         << "  --dataset=ФАЙЛ        запрос к набору данных (отображается в память)\n"
+         << "  --day=D               день недели: 0 - воскресенье, ..., 6 - суббота\n"
+         << "  --from=YYYY-MM-DD     начало диапазона дат (включительно)\n"
+         << "  --to=YYYY-MM-DD       конец диапазона дат (включительно)\n"
+         << "  --coach=ФИО           только тренировки тренера\n"
+         << "  --hours=A-B           время начала в часах [A, B)\n"
+         << "  --index               построить индекс дней недели и дат и отвечать по нему\n"
+         << "  --aggregate           сводка выбранных записей: тренер x день недели, нагрузка по часам\n"
+         << "  --quiet               не выводить найденные записи, только их число и время\n"
+         << "  --bench               замер масштабирования в CSV: последовательный проход против параллельных\n"
+         << "  --sizes=N,M,...       размеры наборов для --bench (по умолчанию 100000,1000000,10000000)\n"
+         << "  --thread-list=A,B,... числа потоков для --bench (по умолчанию 1, 2, 4, ... до числа процессоров)\n"
+         << "  --trials=N            замеряемых прогонов для --bench (по умолчанию 5)\n"
+         << "  --warmup=N            прогревочных прогонов для --bench (по умолчанию 1)\n"
+         << "  --threads=N           число потоков (по умолчанию " << CliOptions().threads << ")\n"
+         << "  --help                эта справка\n";
+}
+
+// Целое в диапазоне [low, high]
+int parseInt(const string& name, const string& value, int low, int high) {
+    size_t used = 0;
+    int result = 0;
+    try {
+        result = stoi(value, &used);
+    } catch (const exception&) {
+        used = 0;
+    }
+    if (used != value.size() || value.empty() || result < low || result > high) {
+        throw invalid_argument("некорректное значение --" + name + "=" + value);
+    }
+    return result;
+}
+
+int32_t parseDateOption(const string& name, const string& value) {
+    int32_t days = 0;
+    if (!parseDate(value.data(), value.size(), days)) {
+        throw invalid_argument("некорректная дата --" + name + "=" + value);
+    }
+    return days;
+}
 
-    for (int i = 0; i < numThreads; ++i) {
-        size_t start = i * trainingsPerThread;
-        size_t end = (i == numThreads - 1) ? trainings.size() : start + trainingsPerThread;
-        threads.emplace_back(processWithThreads, ref(trainings), dayOfWeek, ref(results), start, end);
+// Список целых через запятую, каждое в [low, high]
+vector<int> parseIntList(const string& name, const string& value, int low, int high) {
+    vector<int> result;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = value.find(',', start);
+        result.push_back(parseInt(name, value.substr(start, comma - start), low, high));
+        if (comma == string::npos) {
+            return result;
+        }
+        start = comma + 1;
     }
+}
 
-    for (auto& t : threads) {
-        t.join();
+// Разбор аргументов; false - нужно показать справку
+bool parseArguments(int argc, char* argv[], CliOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (arg == "--index") {
+            options.useIndex = true;
+            continue;
+        }
+        if (arg == "--aggregate") {
+            options.aggregate = true;
+            continue;
+        }
+        if (arg == "--quiet") {
+            options.quiet = true;
+            continue;
+        }
+        if (arg == "--bench") {
+            options.bench = true;
+            continue;
+        }
+        size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == string::npos) {
+            throw invalid_argument("неизвестный параметр " + arg);
+        }
+        string name = arg.substr(2, eq - 2);
+        string value = arg.substr(eq + 1);
+        if (name == "import") {
+            options.importPath = value;
+        } else if (name == "generate") {
+            options.generateCount = parseInt(name, value, 0, INT_MAX);
+        } else if (name == "seed") {
+            size_t used = 0;
+            try {
+                options.seed = stoull(value, &used);
+            } catch (const exception&) {
+                used = 0;
+            }
+            if (used != value.size() || value.empty() || value[0] == '-') {
+                throw invalid_argument("некорректное значение --seed=" + value);
+            }
+        } else if (name == "output") {
+            options.outputPath = value;
+        } else if (name == "dataset") {
+            options.datasetPath = value;
+        } else if (name == "day") {
+            options.query.dayOfWeek = parseInt(name, value, 0, 6);
+        } else if (name == "from") {
+            options.query.fromDay = parseDateOption(name, value);
+        } else if (name == "to") {
+            options.query.toDay = parseDateOption(name, value);
+        } else if (name == "coach") {
+            options.coachName = value;
+        } else if (name == "hours") {
+            size_t dash = value.find('-');
+            if (dash == string::npos) {
+                throw invalid_argument("ожидается --hours=A-B");
+            }
+            int from = parseInt(name, value.substr(0, dash), 0, 24);
+            int to = parseInt(name, value.substr(dash + 1), 0, 24);
+            options.query.fromMinute = static_cast<uint16_t>(from * 60);
+            options.query.toMinute = static_cast<uint16_t>(to * 60);
+        } else if (name == "sizes") {
+            options.benchSizes = parseIntList(name, value, 1, INT_MAX);
+        } else if (name == "thread-list") {
+            options.benchThreads = parseIntList(name, value, 1, 4096);
+        } else if (name == "trials") {
+            options.trials = parseInt(name, value, 1, 1000000);
+        } else if (name == "warmup") {
+            options.warmups = parseInt(name, value, 0, 1000000);
+        } else if (name == "threads") {
+            options.threads = parseInt(name, value, 1, 4096);
+        } else {
+            throw invalid_argument("неизвестный параметр " + arg);
+        }
+    }
+    if (options.bench) {
+        if (options.query.fromDay > options.query.toDay) {
+            throw invalid_argument("пустой диапазон --from..--to");
+        }
+        return true;
     }
+    const bool generating = options.generateCount >= 0;
+    if (options.importPath.empty() && !generating && options.datasetPath.empty()) {
+        throw invalid_argument("нужен --import или --generate с --output или --dataset");
+    }
+    if (!options.importPath.empty() && generating) {
+        throw invalid_argument("--import и --generate не задаются вместе");
+    }
+    if ((options.importPath.empty() && !generating) != options.outputPath.empty()) {
+        throw invalid_argument("--output задается вместе с --import или --generate");
+    }
+    if (generating && (options.query.fromDay == INT32_MIN || options.query.toDay == INT32_MAX ||
+                       options.query.fromDay > options.query.toDay)) {
+        throw invalid_argument("для --generate нужен диапазон --from..--to");
+    }
+    return true;
 }
 
-// Функция для генерации случайных данных о тренировках
-void generateRandomTrainings(vector<Training>& trainings, int size, const string& startDate, const string& endDate) {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> dis(0, 23);
-    uniform_int_distribution<> disMin(0, 59);
+// Медиана и минимум времени серии замеров
+struct TrialTimes {
+    double median = 0;
+    double minimum = 0;
+};
+
+// warmups прогревочных и trials замеряемых прогонов run
+template <typename Run>
+TrialTimes timeTrials(int warmups, int trials, Run&& run) {
+    for (int i = 0; i < warmups; ++i) {
+        run();
+    }
+    vector<double> samples;
+    for (int i = 0; i < trials; ++i) {
+        auto start = chrono::steady_clock::now();
+        run();
+        samples.push_back(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    return {n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2, samples.front()};
+}
 
-    tm startTm = {};
-    stringstream ssStart(startDate);
-    ssStart >> get_time(&startTm, "%Y-%m-%d");
-    time_t startEpoch = mktime(&startTm);
+// Число потоков по умолчанию для замера: 1, 2, 4, ... и число процессоров
+vector<int> defaultThreadCounts() {
+    int cpus = max(1, static_cast<int>(thread::hardware_concurrency()));
+    vector<int> counts;
+    for (int count = 1; count < cpus; count *= 2) {
+        counts.push_back(count);
+    }
+    counts.push_back(cpus);
+    return counts;
+}
 
-    tm endTm = {};
-    stringstream ssEnd(endDate);
-    ssEnd >> get_time(&endTm, "%Y-%m-%d");
-    time_t endEpoch = mktime(&endTm);
+// Неинтерактивный замер масштабирования: для каждого размера набора последовательный
+// проход сравнивается с multiThreadedProcessing и параллельной колоночной выборкой
+// при каждом числе потоков. Отчет - CSV: время, записей в секунду, ускорение и
+// эффективность относительно последовательного прохода, совпадение результатов.
+// Возвращает false, если хотя бы один параллельный результат разошелся с эталоном.
+bool runScalingBenchmark(const CliOptions& options) {
+    const int dayOfWeek = options.query.hasWeekday() ? options.query.dayOfWeek : 1;
+    const int32_t fromDay = options.query.fromDay != INT32_MIN ? options.query.fromDay : daysFromCivil(2020, 1, 1);
+    const int32_t toDay = options.query.toDay != INT32_MAX ? options.query.toDay : daysFromCivil(2024, 12, 31);
+    const vector<int> threadCounts = options.benchThreads.empty() ? defaultThreadCounts() : options.benchThreads;
+    char fromDate[16], toDate[16];
+    fromDate[formatDate(fromDay, fromDate)] = '\0';
+    toDate[formatDate(toDay, toDate)] = '\0';
 
-    vector<string> coaches = {"Иванов И.И.", "Петров П.П.", "Сидоров С.С.", "Кузнецов А.А.", "Смирнов В.В."};
+    cout << "size,threads,method,trials,median_s,min_s,records_per_s,speedup,efficiency,matches,valid\n";
+    cout << setprecision(9);
+    bool allValid = true;
+    auto report = [&](int size, int threads, const char* method, const TrialTimes& times, double baseline, size_t matches,
+                      bool valid) {
+        double speedup = baseline / times.median;
+        cout << size << ',' << threads << ',' << method << ',' << options.trials << ',' << times.median << ','
+             << times.minimum << ',' << size / times.median << ',' << speedup << ',' << speedup / threads << ','
+             << matches << ',' << (valid ? "yes" : "no") << "\n";
+        allValid = allValid && valid;
+    };
 
-    for (int i = 0; i < size; ++i) {
-        time_t randomTime = startEpoch + rand() % (endEpoch - startEpoch + 1);
-        tm* randomTm = localtime(&randomTime);
+    for (int size : options.benchSizes) {
+        vector<Training> trainings;
+        generateRandomTrainings(trainings, size, fromDate, toDate, threadCounts.back(), options.seed);
+        TrainingColumns columns = toColumns(trainings);
+        TrainingQuery query;
+        query.dayOfWeek = dayOfWeek;
 
-        string date = to_string(randomTm->tm_year + 1900) + "-" +
-                      to_string(randomTm->tm_mon + 1) + "-" +
-                      to_string(randomTm->tm_mday);
+        // Эталон: последовательный проход, как в интерактивном режиме
+        vector<Training> expected;
+        TrialTimes sequential = timeTrials(options.warmups, options.trials, [&] {
+            expected.clear();
+            for (const auto& training : trainings) {
+                if (isTrainingOnDay(training, dayOfWeek)) {
+                    expected.push_back(training);
+                }
+            }
+        });
+        vector<uint32_t> expectedRows;
+        for (size_t i = 0; i < trainings.size(); ++i) {
+            if (isTrainingOnDay(trainings[i], dayOfWeek)) {
+                expectedRows.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        report(size, 1, "sequential", sequential, sequential.median, expected.size(), true);
 
-        string time = to_string(dis(gen)) + ":" + (disMin(gen) < 10 ? "0" : "") + to_string(disMin(gen));
+        for (int threads : threadCounts) {
+            // Пул растет, если потоков просят больше, чем в нем есть; растим его до замера,
+            // иначе при --warmup=0 запуск потоков попадет в первый прогон
+            sharedPool(threads);
+            vector<Training> results;
+            TrialTimes multi = timeTrials(options.warmups, options.trials, [&] {
+                results.clear();
+                multiThreadedProcessing(trainings, dayOfWeek, results, threads);
+            });
+            report(size, threads, "multithreaded", multi, sequential.median, results.size(), sameTrainings(results, expected));
 
-        string coachName = coaches[rand() % coaches.size()];
+            vector<uint32_t> rows;
+            TrialTimes columnar = timeTrials(options.warmups, options.trials, [&] {
+                parallelFilterRows(columns.view(), query, rows, threads);
+            });
+            report(size, threads, "columnar", columnar, sequential.median, rows.size(), rows == expectedRows);
+        }
+    }
+    cout.flush();
+    return allValid;
+}
 
-        trainings.push_back({date, time, coachName});
+// Неинтерактивный режим: импорт CSV и/или запрос к набору данных
+int runCommandLine(int argc, char* argv[]) {
+    CliOptions options;
+    try {
+        if (!parseArguments(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (options.bench) {
+            return runScalingBenchmark(options) ? 0 : 1;
+        }
+        cout << fixed << setprecision(5);
+        if (!options.importPath.empty()) {
+            auto start = chrono::high_resolution_clock::now();
+            ImportStats stats = importCsv(options.importPath, options.outputPath, options.threads);
+            double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+            cout << "Импортировано записей: " << stats.rows << " за " << seconds << " секунд";
+            if (stats.skipped) {
+                cout << " (пропущено некорректных строк: " << stats.skipped << ")";
+            }
+            cout << "\n";
+        }
+        if (options.generateCount >= 0) {
+            auto start = chrono::high_resolution_clock::now();
+            TrainingColumns columns;
+            generateTrainingColumns(columns, static_cast<size_t>(options.generateCount), options.query.fromDay,
+                                    options.query.toDay, options.seed, options.threads);
+            double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+            writeDataset(options.outputPath, columns);
+            cout << "Сгенерировано записей: " << columns.size() << " за " << seconds << " секунд (зерно "
+                 << options.seed << ")\n";
+        }
+        if (!options.datasetPath.empty()) {
+            MappedDataset dataset(options.datasetPath);
+            if (!options.coachName.empty()) {
+                auto it = dataset.coaches().ids.find(options.coachName);
+                // Неизвестный тренер: номер вне словаря, совпадений не будет
+                options.query.coach = it != dataset.coaches().ids.end() ? it->second
+                                                                        : static_cast<int>(dataset.coaches().names.size());
+            }
+            if (options.aggregate) {
+                auto start = chrono::high_resolution_clock::now();
+                TrainingAggregate aggregate = aggregateRows(dataset.view(), dataset.coaches(), options.query, options.threads);
+                double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+                printAggregate(aggregate);
+                cout << "Сводка по " << aggregate.total() << " из " << dataset.view().size << " записей за " << seconds
+                     << " секунд\n";
+                return 0;
+            }
+            TrainingIndex index;
+            if (options.useIndex) {
+                auto start = chrono::high_resolution_clock::now();
+                index.append(dataset.view(), options.threads);
+                double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+                cout << "Индекс построен за " << seconds << " секунд, память " << index.memoryBytes() / 1048576.0
+                     << " МиБ\n";
+            }
+            vector<uint32_t> rows;
+            auto start = chrono::high_resolution_clock::now();
+            if (!options.useIndex || !index.query(dataset.view(), options.query, rows)) {
+                parallelFilterRows(dataset.view(), options.query, rows, options.threads);
+            }
+            double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+            if (!options.quiet) {
+                auto startOutput = chrono::high_resolution_clock::now();
+                ResultWriter writer;
+                writer.writeRows(dataset.view(), dataset.coaches(), rows, options.threads);
+                double outputSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - startOutput).count();
+                cerr << "Вывод: " << writer.bytesWritten() << " байт, вызовов записи " << writer.writeCalls() << ", "
+                     << fixed << setprecision(5) << outputSeconds << " секунд\n";
+            }
+            cout << "Найдено " << rows.size() << " из " << dataset.view().size << " записей за " << seconds << " секунд\n";
+        }
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
     }
+    return 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
+
     int size;          // Количество тренировок
     int numThreads;    // Количество параллельных потоков
     int dayOfWeek;     // 0 - воскресенье, 1 - понедельник, ..., 6 - суббота
@@ -109,8 +2441,10 @@ int main() {
     vector<Training> trainings;
     vector<Training> results;
 
-    // Генерация случайных тренировок
-    generateRandomTrainings(trainings, size, startDate, endDate);
+    // Генерация случайных тренировок; зерно печатается, чтобы набор можно было повторить через --seed
+    const uint64_t seed = random_device{}();
+    generateRandomTrainings(trainings, size, startDate, endDate, numThreads, seed);
+    cout << "Зерно генератора: " << seed << "\n";
 
     // Обработка без использования многопоточности
     auto startSingle = chrono::high_resolution_clock::now();
@@ -122,14 +2456,16 @@ int main() {
     auto endSingle = chrono::high_resolution_clock::now();
     double timeWithoutThreads = chrono::duration<double>(endSingle - startSingle).count();
 
-    // Вывод результатов без многопоточности
+    // Вывод результатов без многопоточности (одним потоком форматирования)
     cout << "Результаты обработки без использования многопоточности:\n";
-    for (const auto& training : results) {
-        cout << training.date << " " << training.time << " " << training.coachName << endl;
-    }
+    auto startOutputSingle = chrono::high_resolution_clock::now();
+    ResultWriter(STDOUT_FILENO).writeTrainings(results, 1);
+    auto endOutputSingle = chrono::high_resolution_clock::now();
+    double timeOutputSingle = chrono::duration<double>(endOutputSingle - startOutputSingle).count();
 
-    // Очищаем результаты для многопоточной обработки
-    results.clear();
+    // Сохраняем результаты для сверки и очищаем для многопоточной обработки
+    vector<Training> singleResults;
+    singleResults.swap(results);
 
     // Обработка с использованием многопоточности
     auto startMulti = chrono::high_resolution_clock::now();
@@ -137,16 +2473,89 @@ int main() {
     auto endMulti = chrono::high_resolution_clock::now();
     double timeWithThreads = chrono::duration<double>(endMulti - startMulti).count();
 
-    // Вывод результатов с многопоточностью
+    // Вывод результатов с многопоточностью: порции форматируются параллельно
     cout << "Результаты обработки с использованием многопоточности:\n";
-    for (const auto& training : results) {
-        cout << training.date << " " << training.time << " " << training.coachName << endl;
+    auto startOutputMulti = chrono::high_resolution_clock::now();
+    ResultWriter(STDOUT_FILENO).writeTrainings(results, numThreads);
+    auto endOutputMulti = chrono::high_resolution_clock::now();
+    double timeOutputMulti = chrono::duration<double>(endOutputMulti - startOutputMulti).count();
+
+    // Подсчет и сводка по тем же данным без копирования записей
+    auto startCount = chrono::high_resolution_clock::now();
+    size_t countMulti = multiThreadedCount(trainings, dayOfWeek, numThreads);
+    auto endCount = chrono::high_resolution_clock::now();
+    TrainingAggregate aggregate = aggregateTrainings(trainings, -1, numThreads);
+    auto endAggregate = chrono::high_resolution_clock::now();
+    double timeCount = chrono::duration<double>(endCount - startCount).count();
+    double timeAggregate = chrono::duration<double>(endAggregate - endCount).count();
+    uint64_t aggregateOnDay = 0;
+    for (size_t coach = 0; coach < aggregate.coaches.names.size(); ++coach) {
+        aggregateOnDay += aggregate.coachWeekday(coach, dayOfWeek);
+    }
+
+    // Сравнение разбора дат: get_time против ручного разбора
+    size_t matchesGetTime = 0, matchesFast = 0;
+    auto startGetTime = chrono::high_resolution_clock::now();
+    for (const auto& training : trainings) {
+        matchesGetTime += isTrainingOnDayGetTime(training, dayOfWeek);
     }
+    auto endGetTime = chrono::high_resolution_clock::now();
+    for (const auto& training : trainings) {
+        matchesFast += isTrainingOnDay(training, dayOfWeek);
+    }
+    auto endFast = chrono::high_resolution_clock::now();
+    double timeGetTime = chrono::duration<double>(endGetTime - startGetTime).count();
+    double timeFast = chrono::duration<double>(endFast - endGetTime).count();
+
+    // Обработка по колоночному представлению
+    TrainingColumns columns = toColumns(trainings);
+    vector<uint32_t> rows;
+    auto startColumns = chrono::high_resolution_clock::now();
+    TrainingQuery query;
+    query.dayOfWeek = dayOfWeek;
+    filterRows(columns.view(), query, rows);
+    auto endColumns = chrono::high_resolution_clock::now();
+    double timeColumns = chrono::duration<double>(endColumns - startColumns).count();
+    vector<uint32_t> parallelRows;
+    auto startParallelColumns = chrono::high_resolution_clock::now();
+    parallelFilterRows(columns.view(), query, parallelRows, numThreads);
+    auto endParallelColumns = chrono::high_resolution_clock::now();
+    double timeParallelColumns = chrono::duration<double>(endParallelColumns - startParallelColumns).count();
+
+    // Индекс строится один раз, после чего запрос стоит O(совпадений)
+    TrainingIndex index;
+    auto startIndex = chrono::high_resolution_clock::now();
+    index.append(columns.view(), numThreads);
+    auto endIndex = chrono::high_resolution_clock::now();
+    vector<uint32_t> indexRows;
+    index.query(columns.view(), query, indexRows);
+    auto endIndexQuery = chrono::high_resolution_clock::now();
+    double timeIndexBuild = chrono::duration<double>(endIndex - startIndex).count();
+    double timeIndexQuery = chrono::duration<double>(endIndexQuery - endIndex).count();
 
     // Устанавливаем формат вывода времени
     cout << fixed << setprecision(5);
     cout << "Время обработки без использования многопоточности: " << timeWithoutThreads << " секунд\n";
-    cout << "Время обработки с использованием многопоточности: " << timeWithThreads << " секунд\n";
+    cout << "Время обработки с использованием многопоточности: " << timeWithThreads << " секунд"
+         << (sameTrainings(results, singleResults) ? "" : " (РЕЗУЛЬТАТЫ РАСХОДЯТСЯ)") << "\n";
+    cout << "Время вывода результатов: " << timeOutputSingle << " секунд в один поток, " << timeOutputMulti
+         << " секунд в " << numThreads << "\n";
+    cout << "Время многопоточного подсчета без копирования: " << timeCount << " секунд"
+         << (countMulti == singleResults.size() ? "" : " (РЕЗУЛЬТАТЫ РАСХОДЯТСЯ)") << "\n";
+    cout << "Время сводки тренер x день недели x час: " << timeAggregate << " секунд"
+         << (aggregate.total() == trainings.size() && aggregateOnDay == singleResults.size() ? "" : " (РЕЗУЛЬТАТЫ РАСХОДЯТСЯ)")
+         << "\n";
+    cout << "Время разбора дат через get_time: " << timeGetTime << " секунд\n";
+    cout << "Время ручного разбора дат: " << timeFast << " секунд"
+         << (matchesGetTime == matchesFast ? "" : " (РЕЗУЛЬТАТЫ РАСХОДЯТСЯ)") << "\n";
+    cout << "Время колоночной фильтрации (" << filterKernels(SimdLevel::Avx512).name << "): " << timeColumns
+         << " секунд (найдено " << rows.size() << ")\n";
+    cout << "Время параллельной колоночной фильтрации: " << timeParallelColumns << " секунд"
+         << (parallelRows == rows ? "" : " (РЕЗУЛЬТАТЫ РАСХОДЯТСЯ)") << "\n";
+    cout << "Время построения индекса: " << timeIndexBuild << " секунд (память " << index.memoryBytes() / 1048576.0
+         << " МиБ)\n";
+    cout << "Время запроса по индексу: " << timeIndexQuery << " секунд"
+         << (indexRows == rows ? "" : " (РЕЗУЛЬТАТЫ РАСХОДЯТСЯ)") << "\n";
 
     return 0;
 }
@@ -4,11 +4,33 @@
 #include <condition_variable> // Подключаем библиотеку для работы с условными переменными
 #include <vector>   // Подключаем библиотеку для работы с динамическими массивами (векторами)
 #include <chrono>   // Подключаем библиотеку для работы с временными задержками
+#include <atomic>   // Подключаем библиотеку для атомарных переменных (маски вилок, слоты ожидания)
+#include <memory>   // Подключаем библиотеку для unique_ptr
+#include <random>   // Подключаем библиотеку для генерации случайных чисел
+#include <string>   // Подключаем библиотеку для строк параметров
+#include <algorithm> // Подключаем библиотеку для min и max
+#include <stdexcept> // Подключаем библиотеку для исключений
+#include <coroutine> // Подключаем библиотеку для сопрограмм C++20
+#include <deque>    // Подключаем библиотеку для очереди готовых сопрограмм
+#include <queue>    // Подключаем библиотеку для очереди таймеров
+#include <cstdint>  // Подключаем библиотеку для целых фиксированной ширины
+#include <iomanip>  // Подключаем библиотеку для форматирования вывода
 
 using namespace std; // Используем пространство имен std для упрощения записи
 
-// Класс Server (Сервер), который управляет вилками
-class Server {
+// Общий интерфейс сервера вилок: мыслитель просит обе вилки и возвращает их
+class UtensilServer {
+public:
+    virtual ~UtensilServer() = default;
+    virtual int size() const = 0; // Количество мыслителей (и вилок)
+    // Мыслитель thinkerId берет вилки thinkerId и (thinkerId + 1) % size()
+    virtual void requestUtensils(int thinkerId) = 0;
+    virtual void releaseUtensils(int thinkerId) = 0;
+};
+
+// Класс Server (Сервер), который управляет вилками через один мьютекс;
+// каждое освобождение будит всех ожидающих (оставлен для сравнения)
+class Server : public UtensilServer {
 private:
     mutex accessMutex; // Мьютекс для синхронизации доступа к вилкам
     condition_variable conditionVar; // Условная переменная для уведомления о доступности вилок
@@ -18,11 +40,17 @@ public:
     // Конструктор, инициализирующий количество вилок
     Server(int totalUtensils) : utensils(totalUtensils, true) {} // Инициализируем вектор вилок, устанавливая все в true (свободны)
 
+    int size() const override {
+        return static_cast<int>(utensils.size());
+    }
+
     // Метод для запроса разрешения на использование вилок
-    void requestUtensils(int leftUtensil, int rightUtensil) {
+    void requestUtensils(int thinkerId) override {
+        int leftUtensil = thinkerId; // Вилка слева
+        int rightUtensil = (thinkerId + 1) % size(); // Вилка справа
         unique_lock<mutex> lock(accessMutex); // Блокируем мьютекс для потока
         // Ждем, пока обе вилки станут свободными
-        conditionVar.wait(lock, [this, leftUtensil, rightUtensil]() { 
+        conditionVar.wait(lock, [this, leftUtensil, rightUtensil]() {
             return utensils[leftUtensil] && utensils[rightUtensil]; // Условие ожидания
         });
 
@@ -32,84 +60,872 @@ public:
     }
 
     // Метод для освобождения вилок
-    void releaseUtensils(int leftUtensil, int rightUtensil) {
+    void releaseUtensils(int thinkerId) override {
         unique_lock<mutex> lock(accessMutex); // Блокируем мьютекс для потока
         // Освобождаем вилки
-        utensils[leftUtensil] = true; // Устанавливаем вилку слева как свободную
-        utensils[rightUtensil] = true; // Устанавливаем вилку справа как свободную
+        utensils[thinkerId] = true; // Устанавливаем вилку слева как свободную
+        utensils[(thinkerId + 1) % size()] = true; // Устанавливаем вилку справа как свободную
 
         // Уведомляем всех ожидающих о том, что вилки стали доступны
         conditionVar.notify_all(); // Уведомляем все потоки, ожидающие на условной переменной
     }
 };
 
+// Сервер для тысяч мыслителей без общего мьютекса. Вилки - биты атомарной маски,
+// обе берутся одним CAS (или двумя с откатом, если лежат в разных словах), поэтому
+// никто не держит одну вилку в ожидании второй и взаимная блокировка невозможна.
+// Ожидающий спит на собственном слоте (futex через atomic::wait), освобождение
+// будит только двух соседей, которым достались вилки.
+// Справедливость: голодный мыслитель получает номер очереди и уступает голодному
+// соседу с меньшим номером. Самый старый голодный мыслитель никому не уступает и
+// ест, как только соседи доедят, поэтому голодание исключено.
+// Откат первой вилки (вилки в разных словах) тоже будит левого соседа: он мог
+// не взять вилки только из-за этого короткого захвата и уснуть, а другого
+// освобождения, которое его разбудит, может и не случиться.
+class NeighbourServer : public UtensilServer {
+private:
+    // Слот мыслителя на своей кэш-линии, чтобы соседи не мешали друг другу
+    struct alignas(64) Slot {
+        atomic<uint64_t> ticket{0}; // Номер очереди голодного мыслителя, 0 - не голоден
+        atomic<uint32_t> signal{0}; // Счетчик пробуждений, на нем спит ожидающий
+    };
+
+    int count; // Количество мыслителей
+    vector<atomic<uint64_t>> forkWords; // Биты занятых вилок
+    unique_ptr<Slot[]> slots; // Слоты ожидания мыслителей
+    atomic<uint64_t> nextTicket{1}; // Следующий номер очереди
+
+    int left(int thinkerId) const {
+        return thinkerId == 0 ? count - 1 : thinkerId - 1;
+    }
+
+    int right(int thinkerId) const {
+        return thinkerId + 1 == count ? 0 : thinkerId + 1;
+    }
+
+    // Уступить ли соседу: он голоден и стоит в очереди раньше
+    bool yieldsTo(uint64_t ticket, int neighbour) const {
+        uint64_t other = slots[neighbour].ticket.load(memory_order_seq_cst);
+        return other != 0 && other < ticket;
+    }
+
+    // Атомарно занять вилку fork, если она свободна
+    bool takeFork(int fork) {
+        uint64_t bit = 1ull << (fork % 64);
+        return (forkWords[fork / 64].fetch_or(bit, memory_order_acquire) & bit) == 0;
+    }
+
+    void putFork(int fork) {
+        forkWords[fork / 64].fetch_and(~(1ull << (fork % 64)), memory_order_release);
+    }
+
+    // Попытка взять обе вилки без ожидания
+    bool tryTake(int thinkerId) {
+        int first = thinkerId, second = right(thinkerId);
+        if (first / 64 == second / 64) {
+            // Обе вилки в одном слове: один CAS
+            atomic<uint64_t>& word = forkWords[first / 64];
+            uint64_t mask = (1ull << (first % 64)) | (1ull << (second % 64));
+            uint64_t current = word.load(memory_order_relaxed);
+            while ((current & mask) == 0) {
+                if (word.compare_exchange_weak(current, current | mask, memory_order_acquire, memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        // Вилки в разных словах: вторая занята - первая возвращается,
+        // а левый сосед, деливший ее с нами, будится на повторную проверку
+        if (!takeFork(first)) {
+            return false;
+        }
+        if (!takeFork(second)) {
+            putFork(first);
+            wake(left(thinkerId));
+            return false;
+        }
+        return true;
+    }
+
+    void wake(int thinkerId) {
+        Slot& slot = slots[thinkerId];
+        if (slot.ticket.load(memory_order_seq_cst) != 0) {
+            slot.signal.fetch_add(1, memory_order_seq_cst);
+            slot.signal.notify_one();
+        }
+    }
+
+public:
+    explicit NeighbourServer(int totalUtensils)
+        : count(totalUtensils), forkWords((totalUtensils + 63) / 64), slots(new Slot[totalUtensils]) {
+        if (totalUtensils < 2) {
+            throw invalid_argument("нужно хотя бы два мыслителя");
+        }
+    }
+
+    int size() const override {
+        return count;
+    }
+
+    void requestUtensils(int thinkerId) override {
+        Slot& slot = slots[thinkerId];
+        uint64_t ticket = nextTicket.fetch_add(1, memory_order_relaxed);
+        slot.ticket.store(ticket, memory_order_seq_cst);
+        for (;;) {
+            // Снимок счетчика до проверки: пробуждение после нее не потеряется
+            uint32_t seen = slot.signal.load(memory_order_seq_cst);
+            if (!yieldsTo(ticket, left(thinkerId)) && !yieldsTo(ticket, right(thinkerId)) && tryTake(thinkerId)) {
+                break;
+            }
+            slot.signal.wait(seen, memory_order_seq_cst);
+        }
+        slot.ticket.store(0, memory_order_seq_cst);
+    }
+
+    void releaseUtensils(int thinkerId) override {
+        putFork(thinkerId);
+        putFork(right(thinkerId));
+        // Вилки нужны только соседям - будим их, а не всех
+        wake(left(thinkerId));
+        wake(right(thinkerId));
+    }
+};
+
+// Длительности размышлений и еды в микросекундах: [min, max]
+struct Timing {
+    int thinkMin = 1000000, thinkMax = 2000000;
+    int eatMin = 1000000, eatMax = 2000000;
+};
+
 // Класс Thinker (Мыслитель), представляющий философа
 class Thinker {
 private:
     int thinkerId; // Идентификатор мыслителя
-    Server &server; // Ссылка на сервер, который управляет вилками
-    std::mutex &leftUtensil; // Мьютекс для левой вилки
-    std::mutex &rightUtensil; // Мьютекс для правой вилки
+    UtensilServer &server; // Ссылка на сервер, который управляет вилками
+    const Timing &timing; // Длительности размышлений и еды
+    bool verbose; // Печатать ли сообщения о действиях
+    mt19937 gen; // Генератор длительностей (свой у каждого мыслителя, rand() не потокобезопасен)
 
 public:
+    uint64_t meals = 0; // Сколько раз мыслитель поел
+    chrono::nanoseconds waited{0}; // Суммарное ожидание вилок
+    chrono::nanoseconds longestWait{0}; // Самое долгое ожидание вилок
+
     // Конструктор, инициализирующий мыслителя
-    Thinker(int id, Server &server, std::mutex &leftUtensil, std::mutex &rightUtensil)
-        : thinkerId(id), server(server), leftUtensil(leftUtensil), rightUtensil(rightUtensil) {}
+    Thinker(int id, UtensilServer &server, const Timing &timing, bool verbose)
+        : thinkerId(id), server(server), timing(timing), verbose(verbose), gen(static_cast<unsigned>(id) * 2654435761u + 1) {}
 
-    // Метод, который мыслитель выполняет для еды и размышлений
-    void perform() {
-        while (true) { // Бесконечный цикл
+    // Метод, который мыслитель выполняет для еды и размышлений, пока не поднят флаг stop
+    void perform(const atomic<bool> &stop) {
+        while (!stop.load(memory_order_relaxed)) {
             reflect(); // Мыслитель размышляет
             // Запрос разрешения у сервера на использование вилок (левая и правая)
-            server.requestUtensils(thinkerId, (thinkerId + 1) % 5); 
-            consume(); // Мыслитель ест
+            auto start = chrono::steady_clock::now();
+            server.requestUtensils(thinkerId);
+            auto wait = chrono::steady_clock::now() - start;
+            waited += wait;
+            longestWait = max(longestWait, chrono::duration_cast<chrono::nanoseconds>(wait));
+            consume(); // Мыслитель ест; вилки ему выдал сервер, отдельные мьютексы не нужны
+            ++meals;
             // Освобождение вилок после еды
-            server.releaseUtensils(thinkerId, (thinkerId + 1) % 5); 
+            server.releaseUtensils(thinkerId);
         }
     }
 
     // Метод для размышлений мыслителя
     void reflect() {
-        std::cout << "Мыслитель " << thinkerId << " размышляет...\n"; // Выводим сообщение о размышлениях
-        // Симуляция времени размышлений (от 1 до 2 секунд)
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 + rand() % 1000)); 
+        if (verbose) {
+            std::cout << "Мыслитель " + to_string(thinkerId) + " размышляет...\n"; // Выводим сообщение о размышлениях
+        }
+        pause(timing.thinkMin, timing.thinkMax); // Симуляция времени размышлений
     }
 
     // Метод для еды мыслителя
     void consume() {
-        std::lock(leftUtensil, rightUtensil); // Захватываем мьютексы для вилок
-        std::lock_guard<std::mutex> leftLock(leftUtensil, std::adopt_lock); // Захватываем левую вилку
-        std::lock_guard<std::mutex> rightLock(rightUtensil, std::adopt_lock); // Захватываем правую вилку
-        std::cout << "Мыслитель " << thinkerId << " ест.\n"; // Выводим сообщение о еде
-        // Симуляция времени еды (от 1 до 2 секунд)
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 + rand() % 1000)); 
-        std::cout << "Мыслитель " << thinkerId << " закончил есть.\n"; // Выводим сообщение о завершении еды
+        if (verbose) {
+            std::cout << "Мыслитель " + to_string(thinkerId) + " ест.\n"; // Выводим сообщение о еде
+        }
+        pause(timing.eatMin, timing.eatMax); // Симуляция времени еды
+        if (verbose) {
+            std::cout << "Мыслитель " + to_string(thinkerId) + " закончил есть.\n"; // Выводим сообщение о завершении еды
+        }
+    }
+
+private:
+    // Пауза случайной длительности из [minMicros, maxMicros]
+    void pause(int minMicros, int maxMicros) {
+        int micros = uniform_int_distribution<int>(minMicros, maxMicros)(gen);
+        if (micros > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(micros));
+        }
+    }
+};
+
+// ---- Моделирование на сопрограммах ----
+// Мыслители - сопрограммы C++20 на небольшом пуле потоков. Ожидание вилок и
+// паузы приостанавливают сопрограмму, а не блокируют поток, поэтому число
+// мыслителей ограничено только памятью.
+
+// Планировщик: очередь готовых сопрограмм и очередь таймеров. Часы реальные
+// или виртуальные: виртуальное время переходит к ближайшему таймеру, когда
+// готовых сопрограмм не осталось, так что паузы ничего не стоят.
+class Scheduler {
+public:
+    inline static thread_local int workerIndex = 0; // Номер рабочего потока планировщика
+
+    Scheduler(int workers, bool virtualTime) : workers(max(workers, 1)), virtualTime(virtualTime) {}
+
+    int size() const {
+        return workers;
+    }
+
+    // Текущее время в наносекундах от начала моделирования
+    uint64_t now() {
+        if (virtualTime) {
+            return virtualNow.load(memory_order_acquire);
+        }
+        return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Поставить сопрограмму в очередь готовых
+    void post(coroutine_handle<> handle) {
+        {
+            lock_guard<mutex> lock(m);
+            ready.push_back(handle);
+        }
+        wake.notify_one();
+    }
+
+    // Возобновить сопрограмму в момент time
+    void resumeAt(uint64_t time, coroutine_handle<> handle) {
+        {
+            lock_guard<mutex> lock(m);
+            timers.push({time, nextTimer++, handle});
+        }
+        wake.notify_one();
+    }
+
+    // Ожидание паузы: co_await scheduler.sleepFor(ns)
+    struct Sleep {
+        Scheduler &scheduler;
+        uint64_t duration;
+        bool await_ready() const noexcept { return duration == 0; }
+        void await_suspend(coroutine_handle<> handle) { scheduler.resumeAt(scheduler.now() + duration, handle); }
+        void await_resume() const noexcept {}
+    };
+
+    Sleep sleepFor(uint64_t nanoseconds) {
+        return {*this, nanoseconds};
+    }
+
+    // Запуск tasks сопрограмм (уже поставленных через post) до завершения всех
+    void run(size_t tasks) {
+        alive = tasks;
+        start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back([this, i] {
+                workerIndex = i;
+                workerLoop();
+            });
+        }
+        for (auto &worker : threads) {
+            worker.join();
+        }
+    }
+
+    // Сопрограмма завершилась
+    void taskDone() {
+        lock_guard<mutex> lock(m);
+        if (--alive == 0) {
+            wake.notify_all();
+        }
+    }
+
+private:
+    struct Timer {
+        uint64_t time;
+        uint64_t order; // Порядок постановки: таймеры одного момента идут по очереди
+        coroutine_handle<> handle;
+        bool operator>(const Timer &other) const {
+            return time != other.time ? time > other.time : order > other.order;
+        }
+    };
+
+    int workers;
+    bool virtualTime;
+    mutex m;
+    condition_variable wake;
+    deque<coroutine_handle<>> ready;
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers;
+    uint64_t nextTimer = 0;
+    size_t alive = 0;
+    int running = 0; // Потоков, выполняющих сопрограмму прямо сейчас
+    atomic<uint64_t> virtualNow{0};
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Перенос наступивших таймеров в очередь готовых (под m)
+    void releaseTimers(uint64_t time) {
+        while (!timers.empty() && timers.top().time <= time) {
+            ready.push_back(timers.top().handle);
+            timers.pop();
+        }
+    }
+
+    void workerLoop() {
+        unique_lock<mutex> lock(m);
+        for (;;) {
+            if (!ready.empty()) {
+                coroutine_handle<> handle = ready.front();
+                ready.pop_front();
+                ++running;
+                lock.unlock();
+                handle.resume();
+                lock.lock();
+                --running;
+                if (running == 0 && ready.empty()) {
+                    wake.notify_all(); // Возможно, пора двигать виртуальное время
+                }
+                continue;
+            }
+            if (alive == 0) {
+                return;
+            }
+            if (timers.empty()) {
+                wake.wait(lock);
+            } else if (virtualTime) {
+                if (running == 0) {
+                    // Все готовое выполнено: часы переходят к ближайшему таймеру
+                    virtualNow.store(timers.top().time, memory_order_release);
+                    releaseTimers(timers.top().time);
+                    wake.notify_all();
+                } else {
+                    wake.wait(lock);
+                }
+            } else {
+                uint64_t current = now();
+                if (timers.top().time <= current) {
+                    releaseTimers(current);
+                    wake.notify_all();
+                } else {
+                    wake.wait_until(lock, start + chrono::nanoseconds(timers.top().time));
+                }
+            }
+        }
+    }
+};
+
+// Сопрограмма мыслителя: запускается планировщиком, кадр освобождается по завершении
+struct SimTask {
+    struct promise_type {
+        SimTask get_return_object() { return {coroutine_handle<promise_type>::from_promise(*this)}; }
+        suspend_always initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+    coroutine_handle<promise_type> handle;
+};
+
+// Арбитр вилок для сопрограмм: acquire либо сразу выдает обе вилки (true), либо
+// запоминает сопрограмму и возобновляет ее через планировщик, когда выдаст вилки
+class ForkArbiter {
+public:
+    explicit ForkArbiter(Scheduler &scheduler, int count) : scheduler(scheduler), count(count) {}
+    virtual ~ForkArbiter() = default;
+    virtual bool acquire(int thinkerId, coroutine_handle<> handle) = 0;
+    virtual void release(int thinkerId) = 0;
+
+    // co_await arbiter.forks(id)
+    struct Forks {
+        ForkArbiter &arbiter;
+        int thinkerId;
+        bool await_ready() const noexcept { return false; }
+        // После передачи сопрограммы арбитру ее могут возобновить в другом потоке:
+        // кадр здесь больше не трогается
+        bool await_suspend(coroutine_handle<> handle) { return !arbiter.acquire(thinkerId, handle); }
+        void await_resume() const noexcept {}
+    };
+
+    Forks forks(int thinkerId) {
+        return {*this, thinkerId};
+    }
+
+protected:
+    Scheduler &scheduler;
+    int count;
+
+    int left(int thinkerId) const {
+        return thinkerId == 0 ? count - 1 : thinkerId - 1;
+    }
+
+    int right(int thinkerId) const {
+        return thinkerId + 1 == count ? 0 : thinkerId + 1;
+    }
+};
+
+// Один список ожидающих: каждое освобождение просматривает всех ожидающих
+// (аналог Server с notify_all); справедливости нет
+class CentralArbiter : public ForkArbiter {
+private:
+    mutex m;
+    vector<char> busy; // Занятые вилки
+    vector<pair<int, coroutine_handle<>>> waiting; // Ожидающие в порядке прихода
+
+public:
+    CentralArbiter(Scheduler &scheduler, int count) : ForkArbiter(scheduler, count), busy(count, 0) {}
+
+    bool acquire(int thinkerId, coroutine_handle<> handle) override {
+        lock_guard<mutex> lock(m);
+        if (!busy[thinkerId] && !busy[right(thinkerId)]) {
+            busy[thinkerId] = busy[right(thinkerId)] = 1;
+            return true;
+        }
+        waiting.emplace_back(thinkerId, handle);
+        return false;
+    }
+
+    void release(int thinkerId) override {
+        lock_guard<mutex> lock(m);
+        busy[thinkerId] = busy[right(thinkerId)] = 0;
+        size_t kept = 0;
+        for (auto &waiter : waiting) {
+            int id = waiter.first;
+            if (!busy[id] && !busy[right(id)]) {
+                busy[id] = busy[right(id)] = 1;
+                scheduler.post(waiter.second);
+            } else {
+                waiting[kept++] = waiter;
+            }
+        }
+        waiting.resize(kept);
+    }
+};
+
+// Адресная выдача с номерами очереди, как у NeighbourServer: голодный уступает
+// голодному соседу с меньшим номером, освобождение проверяет только двух соседей
+class NeighbourArbiter : public ForkArbiter {
+private:
+    mutex m;
+    vector<char> busy; // Занятые вилки
+    vector<uint64_t> tickets; // Номер очереди голодного, 0 - не голоден
+    vector<coroutine_handle<>> waiters; // Приостановленные в ожидании вилок
+    uint64_t nextTicket = 1;
+
+    bool canEat(int thinkerId) const {
+        uint64_t ticket = tickets[thinkerId];
+        auto olderNeighbour = [&](int neighbour) { return tickets[neighbour] != 0 && tickets[neighbour] < ticket; };
+        return !busy[thinkerId] && !busy[right(thinkerId)] && !olderNeighbour(left(thinkerId)) &&
+               !olderNeighbour(right(thinkerId));
+    }
+
+    void grant(int thinkerId) {
+        busy[thinkerId] = busy[right(thinkerId)] = 1;
+        tickets[thinkerId] = 0;
+    }
+
+public:
+    NeighbourArbiter(Scheduler &scheduler, int count)
+        : ForkArbiter(scheduler, count), busy(count, 0), tickets(count, 0), waiters(count) {}
+
+    bool acquire(int thinkerId, coroutine_handle<> handle) override {
+        lock_guard<mutex> lock(m);
+        tickets[thinkerId] = nextTicket++;
+        if (canEat(thinkerId)) {
+            grant(thinkerId);
+            return true;
+        }
+        waiters[thinkerId] = handle;
+        return false;
+    }
+
+    void release(int thinkerId) override {
+        lock_guard<mutex> lock(m);
+        busy[thinkerId] = busy[right(thinkerId)] = 0;
+        for (int neighbour : {left(thinkerId), right(thinkerId)}) {
+            if (waiters[neighbour] && canEat(neighbour)) {
+                grant(neighbour);
+                scheduler.post(waiters[neighbour]);
+                waiters[neighbour] = nullptr;
+            }
+        }
+    }
+};
+
+// Иерархия ресурсов: сначала вилка с меньшим номером, затем с большим; у каждой
+// вилки очередь ожидающих (FIFO), освобожденная вилка передается первому в очереди
+class OrderedArbiter : public ForkArbiter {
+private:
+    mutex m;
+    vector<char> busy; // Занятые вилки
+    vector<int> head, tail; // Очереди вилок: первый и последний ожидающий, -1 - пусто
+    vector<int> next; // Следующий в очереди той вилки, которую ждет мыслитель
+    vector<coroutine_handle<>> waiters;
+
+    int firstFork(int thinkerId) const { return min(thinkerId, right(thinkerId)); }
+    int secondFork(int thinkerId) const { return max(thinkerId, right(thinkerId)); }
+
+    void enqueue(int fork, int thinkerId) {
+        next[thinkerId] = -1;
+        if (tail[fork] < 0) {
+            head[fork] = thinkerId;
+        } else {
+            next[tail[fork]] = thinkerId;
+        }
+        tail[fork] = thinkerId;
+    }
+
+    // Вторая вилка: сразу или в очередь; true - обе вилки у мыслителя
+    bool takeSecond(int thinkerId) {
+        int fork = secondFork(thinkerId);
+        if (!busy[fork]) {
+            busy[fork] = 1;
+            return true;
+        }
+        enqueue(fork, thinkerId);
+        return false;
+    }
+
+    // Освобождение вилки: передача первому ожидающему или пометка свободной
+    void handOver(int fork) {
+        int thinkerId = head[fork];
+        if (thinkerId < 0) {
+            busy[fork] = 0;
+            return;
+        }
+        head[fork] = next[thinkerId];
+        if (head[fork] < 0) {
+            tail[fork] = -1;
+        }
+        // Вилка остается занятой и переходит к thinkerId
+        if (fork == secondFork(thinkerId) || takeSecond(thinkerId)) {
+            scheduler.post(waiters[thinkerId]);
+        }
+    }
+
+public:
+    OrderedArbiter(Scheduler &scheduler, int count)
+        : ForkArbiter(scheduler, count), busy(count, 0), head(count, -1), tail(count, -1), next(count, -1), waiters(count) {}
+
+    bool acquire(int thinkerId, coroutine_handle<> handle) override {
+        lock_guard<mutex> lock(m);
+        waiters[thinkerId] = handle;
+        int fork = firstFork(thinkerId);
+        if (busy[fork]) {
+            enqueue(fork, thinkerId);
+            return false;
+        }
+        busy[fork] = 1;
+        return takeSecond(thinkerId);
+    }
+
+    void release(int thinkerId) override {
+        lock_guard<mutex> lock(m);
+        handOver(firstFork(thinkerId));
+        handOver(secondFork(thinkerId));
+    }
+};
+
+// Гистограмма длительностей в наносекундах: логарифмические корзины по 8 подкорзин
+// (погрешность не больше 12.5%)
+struct alignas(64) WaitHistogram {
+    static constexpr int BUCKETS = 16 + 60 * 8;
+    uint64_t counts[BUCKETS] = {};
+
+    static int bucket(uint64_t value) {
+        if (value < 16) {
+            return static_cast<int>(value);
+        }
+        int exponent = 63 - __builtin_clzll(value);
+        return 16 + (exponent - 4) * 8 + static_cast<int>((value >> (exponent - 3)) & 7);
+    }
+
+    // Верхняя граница корзины
+    static uint64_t upperBound(int index) {
+        if (index < 16) {
+            return static_cast<uint64_t>(index);
+        }
+        int exponent = (index - 16) / 8 + 4;
+        uint64_t sub = static_cast<uint64_t>((index - 16) % 8);
+        return ((8 + sub + 1) << (exponent - 3)) - 1;
+    }
+
+    void add(uint64_t value) {
+        ++counts[bucket(value)];
     }
+
+    void merge(const WaitHistogram &other) {
+        for (int i = 0; i < BUCKETS; ++i) {
+            counts[i] += other.counts[i];
+        }
+    }
+
+    uint64_t percentile(double fraction) const {
+        uint64_t total = 0;
+        for (uint64_t count : counts) {
+            total += count;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen > rank) {
+                return upperBound(i);
+            }
+        }
+        return 0;
+    }
+};
+
+// Итоги одного мыслителя в моделировании
+struct ThinkerStats {
+    uint64_t meals = 0; // Приемов пищи
+    uint64_t longestWait = 0; // Самое долгое ожидание вилок, нс
+};
+
+// Общие данные моделирования
+struct Simulation {
+    Scheduler &scheduler;
+    ForkArbiter &arbiter;
+    const Timing &timing;
+    uint64_t endTime; // Момент, после которого мыслители заканчивают, нс
+    vector<ThinkerStats> stats;
+    vector<WaitHistogram> histograms; // По одной на рабочий поток
+};
+
+// Число из [minMicros, maxMicros] в наносекундах; состояние SplitMix64 - у каждого мыслителя свое
+uint64_t randomNanos(uint64_t &state, int minMicros, int maxMicros) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    uint64_t span = static_cast<uint64_t>(maxMicros - minMicros) + 1;
+    return (static_cast<uint64_t>(minMicros) + z % span) * 1000;
+}
+
+// Цикл мыслителя: размышление, ожидание вилок, еда, возврат вилок
+SimTask thinkerTask(Simulation &sim, int thinkerId) {
+    uint64_t rng = static_cast<uint64_t>(thinkerId) * 0x2545f4914f6cdd1dull;
+    ThinkerStats &stats = sim.stats[thinkerId];
+    while (sim.scheduler.now() < sim.endTime) {
+        co_await sim.scheduler.sleepFor(randomNanos(rng, sim.timing.thinkMin, sim.timing.thinkMax));
+        uint64_t start = sim.scheduler.now();
+        co_await sim.arbiter.forks(thinkerId);
+        uint64_t wait = sim.scheduler.now() - start;
+        sim.histograms[Scheduler::workerIndex].add(wait);
+        stats.longestWait = max(stats.longestWait, wait);
+        co_await sim.scheduler.sleepFor(randomNanos(rng, sim.timing.eatMin, sim.timing.eatMax));
+        ++stats.meals;
+        sim.arbiter.release(thinkerId);
+    }
+    sim.scheduler.taskDone();
+}
+
+// Моделирование: приемы пищи в секунду модельного и реального времени,
+// перцентили ожидания вилок и голодание отдельных мыслителей
+void runSimulation(int thinkers, const string &strategy, int workers, bool virtualTime, double seconds,
+                   const Timing &timing) {
+    Scheduler scheduler(workers, virtualTime);
+    unique_ptr<ForkArbiter> arbiter;
+    if (strategy == "central") {
+        arbiter.reset(new CentralArbiter(scheduler, thinkers));
+    } else if (strategy == "ordered") {
+        arbiter.reset(new OrderedArbiter(scheduler, thinkers));
+    } else {
+        arbiter.reset(new NeighbourArbiter(scheduler, thinkers));
+    }
+    Simulation sim{scheduler, *arbiter, timing, static_cast<uint64_t>(seconds * 1e9),
+                   vector<ThinkerStats>(thinkers), vector<WaitHistogram>(scheduler.size())};
+    for (int i = 0; i < thinkers; ++i) {
+        scheduler.post(thinkerTask(sim, i).handle);
+    }
+    auto start = chrono::steady_clock::now();
+    scheduler.run(static_cast<size_t>(thinkers));
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double simulated = static_cast<double>(scheduler.now()) / 1e9;
+
+    WaitHistogram waits;
+    for (const auto &histogram : sim.histograms) {
+        waits.merge(histogram);
+    }
+    uint64_t meals = 0, fewest = UINT64_MAX, most = 0, longestWait = 0, starved = 0;
+    double squares = 0;
+    for (const auto &stats : sim.stats) {
+        meals += stats.meals;
+        fewest = min(fewest, stats.meals);
+        most = max(most, stats.meals);
+        longestWait = max(longestWait, stats.longestWait);
+        starved += stats.meals == 0;
+        squares += static_cast<double>(stats.meals) * static_cast<double>(stats.meals);
+    }
+    // Индекс Джайна: 1 - все ели поровну, 1/N - ел один
+    double fairness = squares > 0 ? static_cast<double>(meals) * static_cast<double>(meals) / (thinkers * squares) : 0;
+
+    cout << fixed << setprecision(1);
+    cout << "Стратегия: " << strategy << ", мыслителей: " << thinkers << ", потоков: " << scheduler.size()
+         << ", часы: " << (virtualTime ? "виртуальные" : "реальные") << "\n"
+         << "Приемов пищи: " << meals << " (" << meals / simulated << " в секунду модели, " << meals / wall
+         << " в секунду реального времени)\n"
+         << setprecision(3) << "Модельное время: " << simulated << " с, реальное: " << wall << " с\n"
+         << setprecision(1) << "Ожидание вилок, мкс: p50 " << waits.percentile(0.5) / 1e3 << ", p90 " << waits.percentile(0.9) / 1e3
+         << ", p99 " << waits.percentile(0.99) / 1e3 << ", p99.9 " << waits.percentile(0.999) / 1e3 << ", max "
+         << longestWait / 1e3 << "\n"
+         << "Приемов пищи на мыслителя: от " << fewest << " до " << most << ", не поел ни разу: " << starved
+         << ", индекс справедливости: " << setprecision(4) << fairness << "\n";
+}
+
+// Параметры запуска
+struct Options {
+    int thinkers = 5; // Количество мыслителей
+    string server = "neighbour"; // Сервер вилок: neighbour, central или ordered (только для сопрограмм)
+    double seconds = 0; // Длительность замера; 0 - бесконечный показ с сообщениями
+    bool coroutines = false; // Моделирование на сопрограммах вместо потока на мыслителя
+    int workers = max(1, static_cast<int>(thread::hardware_concurrency())); // Потоков пула сопрограмм
+    bool virtualTime = false; // Виртуальные часы: паузы не занимают реального времени
+    Timing timing; // Длительности размышлений и еды
 };
 
-int main() {
-    const int totalThinkers = 5; // Количество мыслителей
+// Разбор "--name=value"; false - нужно показать справку
+bool parseArguments(int argc, char* argv[], Options &options) {
+    auto parseRange = [](const string &value, int &low, int &high) {
+        size_t dash = value.find('-');
+        low = stoi(value.substr(0, dash));
+        high = dash == string::npos ? low : stoi(value.substr(dash + 1));
+        if (low < 0 || high < low) {
+            throw invalid_argument("некорректный диапазон " + value);
+        }
+    };
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string name = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--help") {
+            return false;
+        } else if (name == "--thinkers") {
+            options.thinkers = stoi(value);
+            if (options.thinkers < 2) {
+                throw invalid_argument("нужно хотя бы два мыслителя");
+            }
+        } else if (name == "--server") {
+            if (value != "neighbour" && value != "central" && value != "ordered") {
+                throw invalid_argument("неизвестный сервер " + value);
+            }
+            options.server = value;
+        } else if (name == "--mode") {
+            if (value != "threads" && value != "coro") {
+                throw invalid_argument("неизвестный режим " + value);
+            }
+            options.coroutines = value == "coro";
+        } else if (name == "--workers") {
+            options.workers = stoi(value);
+            if (options.workers < 1) {
+                throw invalid_argument("нужен хотя бы один поток");
+            }
+        } else if (name == "--clock") {
+            if (value != "real" && value != "virtual") {
+                throw invalid_argument("неизвестные часы " + value);
+            }
+            options.virtualTime = value == "virtual";
+        } else if (name == "--seconds") {
+            options.seconds = stod(value);
+        } else if (name == "--think-us") {
+            parseRange(value, options.timing.thinkMin, options.timing.thinkMax);
+        } else if (name == "--eat-us") {
+            parseRange(value, options.timing.eatMin, options.timing.eatMax);
+        } else {
+            throw invalid_argument("неизвестный параметр " + arg);
+        }
+    }
+    if (options.coroutines && options.seconds <= 0) {
+        throw invalid_argument("для --mode=coro нужен --seconds");
+    }
+    if (!options.coroutines && options.server == "ordered") {
+        throw invalid_argument("--server=ordered доступен только при --mode=coro");
+    }
+    return true;
+}
 
-    std::vector<std::mutex> utensils(totalThinkers); // Создаем массив мьютексов для вилок
-    Server server(totalThinkers); // Создаем сервер, который будет управлять вилками
+void printUsage(const char* program) {
+    cout << "Использование: " << program << " [параметры]\n"
+         << "Без --seconds - бесконечный показ с сообщениями мыслителей.\n"
+         << "  --thinkers=N          количество мыслителей (по умолчанию 5)\n"
+         << "  --server=KIND         neighbour (адресные пробуждения, по умолчанию), central (один мьютекс)\n"
+         << "                        или ordered (иерархия вилок с очередями, только для --mode=coro)\n"
+         << "  --seconds=S           замер на S секунд: приемов пищи в секунду и справедливость\n"
+         << "  --mode=MODE           threads (поток на мыслителя, по умолчанию) или coro (сопрограммы на пуле)\n"
+         << "  --workers=N           потоков пула для --mode=coro (по умолчанию число процессоров)\n"
+         << "  --clock=CLOCK         real (по умолчанию) или virtual - модельное время для --mode=coro\n"
+         << "  --think-us=A-B        длительность размышлений в микросекундах (по умолчанию 1000000-2000000)\n"
+         << "  --eat-us=A-B          длительность еды в микросекундах (по умолчанию 1000000-2000000)\n"
+         << "  --help                эта справка\n";
+}
 
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseArguments(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 0;
+        }
+    } catch (const exception &e) {
+        cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    const int totalThinkers = options.thinkers; // Количество мыслителей
+    if (options.coroutines) {
+        runSimulation(totalThinkers, options.server, options.workers, options.virtualTime, options.seconds, options.timing);
+        return 0;
+    }
+    const bool measure = options.seconds > 0; // Замер или бесконечный показ
+
+    unique_ptr<UtensilServer> server; // Сервер, который будет управлять вилками
+    if (options.server == "central") {
+        server.reset(new Server(totalThinkers));
+    } else {
+        server.reset(new NeighbourServer(totalThinkers));
+    }
+
+    std::vector<std::unique_ptr<Thinker>> thinkers; // Мыслители
+    for (int i = 0; i < totalThinkers; ++i) {
+        thinkers.emplace_back(new Thinker(i, *server, options.timing, !measure));
+    }
+
+    atomic<bool> stop{false}; // Флаг завершения замера
     std::vector<std::thread> thinkerThreads; // Вектор для потоков мыслителей
 
-    // Создаем мыслителей и соответствующие потоки
+    // Создаем потоки мыслителей
+    auto start = chrono::steady_clock::now();
     for (int i = 0; i < totalThinkers; ++i) {
-        thinkerThreads.emplace_back(
-            [i, &server, &utensils]() {
-                // Создаем объект мыслителя и запускаем его метод perform() в потоке
-                Thinker thinker(i, server, utensils[i], utensils[(i + 1) % totalThinkers]);
-                thinker.perform(); 
-            }
-        );
-    } 
+        thinkerThreads.emplace_back([&thinkers, &stop, i]() { thinkers[i]->perform(stop); });
+    }
+
+    if (measure) {
+        this_thread::sleep_for(chrono::duration<double>(options.seconds));
+        stop.store(true);
+    }
 
     // Ожидаем завершения всех потоков
     for (auto &thread : thinkerThreads) {
         thread.join(); // Ожидаем завершения каждого потока
     }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Итоги замера: пропускная способность и справедливость
+    uint64_t meals = 0, fewest = UINT64_MAX, most = 0;
+    chrono::nanoseconds waited{0}, longestWait{0};
+    for (const auto &thinker : thinkers) {
+        meals += thinker->meals;
+        fewest = min(fewest, thinker->meals);
+        most = max(most, thinker->meals);
+        waited += thinker->waited;
+        longestWait = max(longestWait, thinker->longestWait);
+    }
+    cout << "Сервер: " << options.server << ", мыслителей: " << totalThinkers << "\n"
+         << "Приемов пищи: " << meals << " (" << meals / elapsed << " в секунду)\n"
+         << "Приемов пищи на мыслителя: от " << fewest << " до " << most << "\n"
+         << "Среднее ожидание вилок: " << (meals ? chrono::duration<double, micro>(waited).count() / meals : 0)
+         << " мкс, наибольшее: " << chrono::duration<double, micro>(longestWait).count() << " мкс\n";
 
     return 0; // Завершение программы
 }